@@ -0,0 +1,259 @@
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <vector>
+
+#include "../Pathfinding/pathfinding.h"
+
+//Frame-budgeted path searches.
+//Requesters queue a search under their id. Once per frame run() spends at most budget_us
+//microseconds on the queue: it always advances the request with the best priority (the
+//smallest value, e.g. the distance to the player) by slice expansions and then looks at the
+//clock again. A search that is not finished when the budget runs out keeps its AStarContext
+//and resumes the next frame, so a long search is spread over frames instead of stalling one.
+//At most max_searches searches are suspended at a time, each of them owns a context.
+//
+//PATH_HPA queries cannot be suspended, they run whole and are charged to the budget.
+//A suspended search restarts if the grid changes underneath it.
+
+
+struct AiSchedulerStats {
+    double budget_us = 0.0;
+    double used_us = 0.0;           //spent in the last run()
+    double average_us = 0.0;        //moving average of used_us
+    double max_used_us = 0.0;
+    int expansions = 0;             //cells expanded in the last run()
+    int completed = 0;              //searches finished in the last run()
+    int deferred = 0;               //requests still queued or suspended after the last run()
+    int suspended = 0;              //of those, searches that were started
+    uint32_t frames = 0;
+    uint32_t over_budget_frames = 0;    //runs that overshot the budget by more than one slice
+};
+
+class AiScheduler {
+public:
+    AiScheduler(double budget_us_ = 1000.0, int slice_ = 128, int max_searches_ = 4)
+        : budget_us(budget_us_), slice(slice_), max_searches(max_searches_) {}
+
+    void set_budget(double us) { budget_us = us; }
+    void set_slice(int expansions) { slice = std::max(expansions, 1); }
+    //ALT tables for all searches, ignored while they are stale
+    void set_landmarks(const Landmarks *landmarks_) {
+        landmarks = landmarks_;
+        for (auto &ctx : contexts) ctx->landmarks = landmarks;
+    }
+
+    //queue a search for id, a request of id that is still queued is replaced
+    //a suspended search of id keeps running, it is only restarted if the goal changed
+    void request(int id, Cell start, Cell goal, float priority, PathMode mode = PATH_JPS) {
+        Job *job = find(id);
+        if (job == nullptr) {
+            jobs.emplace_back();
+            job = &jobs.back();
+            job->id = id;
+        } else if (job->ctx >= 0 && !job->done && job->goal == goal && job->mode == mode) {
+            job->priority = priority;
+            return;
+        }
+        release_context(*job);
+        job->start = start;
+        job->goal = goal;
+        job->priority = priority;
+        job->mode = mode;
+        job->done = false;
+        job->status = SEARCH_IN_PROGRESS;
+        job->path.clear();
+    }
+
+    //true while the search of id is queued or suspended
+    bool pending(int id) const {
+        const Job *job = find(id);
+        return job != nullptr && !job->done;
+    }
+
+    //if the search of id has finished, hand its result over and forget it
+    bool collect(int id, std::vector<Cell> &path, SearchStatus &status) {
+        for (size_t i = 0; i < jobs.size(); i++) {
+            if (jobs[i].id != id || !jobs[i].done) continue;
+            status = jobs[i].status;
+            path.swap(jobs[i].path);
+            erase(i);
+            return true;
+        }
+        return false;
+    }
+
+    void cancel(int id) {
+        for (size_t i = 0; i < jobs.size(); i++) {
+            if (jobs[i].id == id) {
+                erase(i);
+                return;
+            }
+        }
+    }
+
+    //allocate the search contexts for grid up front, so the first searches do not pay for it
+    void reserve(const NavGrid &grid) {
+        while ((int)contexts.size() < max_searches) {
+            contexts.emplace_back(new AStarContext());
+            contexts.back()->landmarks = landmarks;
+            contexts_free.push_back((int)contexts.size() - 1);
+        }
+        for (auto &ctx : contexts) {
+            if ((int)ctx->g.size() != grid.size()) ctx->resize(grid.size());
+        }
+    }
+
+    void clear() {
+        jobs.clear();
+        contexts_free.clear();
+        for (size_t c = 0; c < contexts.size(); c++) contexts_free.push_back((int)c);
+    }
+
+    //spend up to the budget on the queued searches, call once per frame
+    void run(const NavGrid &grid, const JumpTable *table = nullptr, HpaGraph *hpa = nullptr) {
+        auto begin = std::chrono::steady_clock::now();
+        auto spent = [&]() {
+            return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - begin).count();
+        };
+        statistics.expansions = 0;
+        statistics.completed = 0;
+        double last_slice = 0.0;
+
+        while (true) {
+            double used = spent();
+            if (used >= budget_us) break;
+            Job *job = next_job();
+            if (job == nullptr) break;
+
+            double before = used;
+            if (job->mode == PATH_HPA) {
+                run_whole(grid, *job, table, hpa);
+            } else {
+                run_slice(grid, *job, table);
+            }
+            last_slice = spent() - before;
+        }
+
+        double used = spent();
+        statistics.budget_us = budget_us;
+        statistics.used_us = used;
+        statistics.average_us = statistics.frames == 0 ? used : 0.9 * statistics.average_us + 0.1 * used;
+        statistics.max_used_us = std::max(statistics.max_used_us, used);
+        statistics.frames++;
+        if (used > budget_us + last_slice) statistics.over_budget_frames++;
+        statistics.deferred = 0;
+        statistics.suspended = 0;
+        for (const Job &job : jobs) {
+            if (job.done) continue;
+            statistics.deferred++;
+            statistics.suspended += job.ctx >= 0;
+        }
+    }
+
+    const AiSchedulerStats &stats() const { return statistics; }
+
+private:
+    struct Job {
+        int id = -1;
+        Cell start, goal;
+        float priority = 0.0f;
+        PathMode mode = PATH_JPS;
+        int ctx = -1;               //context of the suspended search, -1 if not started
+        uint32_t version = 0;       //grid version the search started on
+        bool done = false;
+        SearchStatus status = SEARCH_IN_PROGRESS;
+        std::vector<Cell> path;
+    };
+
+    Job *find(int id) {
+        for (Job &job : jobs) {
+            if (job.id == id) return &job;
+        }
+        return nullptr;
+    }
+
+    const Job *find(int id) const {
+        for (const Job &job : jobs) {
+            if (job.id == id) return &job;
+        }
+        return nullptr;
+    }
+
+    void erase(size_t i) {
+        release_context(jobs[i]);
+        jobs[i] = std::move(jobs.back());
+        jobs.pop_back();
+    }
+
+    void release_context(Job &job) {
+        if (job.ctx >= 0) contexts_free.push_back(job.ctx);
+        job.ctx = -1;
+    }
+
+    //best priority among the started searches and, if a context is available, the waiting ones
+    Job *next_job() {
+        bool can_start = !contexts_free.empty() || (int)contexts.size() < max_searches;
+        Job *best = nullptr;
+        for (Job &job : jobs) {
+            if (job.done) continue;
+            if (job.ctx < 0 && !can_start) continue;
+            if (best == nullptr || job.priority < best->priority) best = &job;
+        }
+        return best;
+    }
+
+    AStarContext &context(Job &job) {
+        if (job.ctx < 0) {
+            if (contexts_free.empty()) {
+                contexts.emplace_back(new AStarContext());
+                contexts.back()->landmarks = landmarks;
+                contexts_free.push_back((int)contexts.size() - 1);
+            }
+            job.ctx = contexts_free.back();
+            contexts_free.pop_back();
+        }
+        return *contexts[job.ctx];
+    }
+
+    void finish(const NavGrid &grid, Job &job, AStarContext &ctx, SearchStatus status) {
+        job.status = status;
+        job.done = true;
+        if (status == SEARCH_FOUND) ctx.extract_path(grid, job.path);
+        release_context(job);
+        statistics.completed++;
+    }
+
+    void run_slice(const NavGrid &grid, Job &job, const JumpTable *table) {
+        bool started = job.ctx >= 0;
+        AStarContext &ctx = context(job);
+        if (!started || job.version != grid.version) {
+            job.version = grid.version;
+            if (a_star_begin(grid, job.start, job.goal, ctx) != SEARCH_IN_PROGRESS) {
+                finish(grid, job, ctx, ctx.status);
+                return;
+            }
+        }
+        int expanded = ctx.expanded;
+        SearchStatus status = find_path_run(grid, ctx, job.mode, slice, table);
+        statistics.expansions += ctx.expanded - expanded;
+        if (status != SEARCH_IN_PROGRESS) finish(grid, job, ctx, status);
+    }
+
+    void run_whole(const NavGrid &grid, Job &job, const JumpTable *table, HpaGraph *hpa) {
+        AStarContext &ctx = context(job);
+        SearchStatus status = find_path(grid, job.start, job.goal, ctx, job.mode, table, hpa);
+        statistics.expansions += ctx.expanded;
+        finish(grid, job, ctx, status);
+    }
+
+    double budget_us;
+    int slice;
+    int max_searches;
+    const Landmarks *landmarks = nullptr;
+    std::vector<Job> jobs;
+    std::vector<std::unique_ptr<AStarContext>> contexts;
+    std::vector<int> contexts_free;
+    AiSchedulerStats statistics;
+};
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdlib>
+#include <algorithm>
+#include <vector>
+
+//NPC storage and AI tick scheduling.
+//Every NPC attribute lives in its own array indexed by the NPC id (structure of arrays), so
+//the per-frame passes over all NPCs only touch the fields they read.
+//
+//An NPC does not think every frame. Its tick interval follows its distance to the player
+//(level of detail): near ones tick every frame, farther ones every few frames. The phase of
+//each NPC is staggered so the far ones spread over the frames instead of all ticking at once.
+//schedule() collects the NPCs due this frame and groups them by state, so the game runs one
+//tight loop per state over batches[state]. With most NPCs far away the AI cost per frame
+//grows with the number of near NPCs plus a fraction of the rest, not with the total.
+
+
+enum NpcState : uint8_t {
+    NPC_IDLE,           //nothing to do, e.g. the player is out of range
+    NPC_CHASE,          //walking toward the player
+    NPC_ATTACK,         //shooting at the player
+    NPC_DEAD,
+    NPC_NUM_STATES
+};
+
+//distance bands of the tick rates, distances are Chebyshev distances in world units
+struct NpcLodSettings {
+    float near_distance = 60.0f;    //up to here every frame
+    float mid_distance = 120.0f;    //up to here every mid_interval frames
+    int mid_interval = 4;
+    int far_interval = 16;          //beyond mid_distance
+};
+
+struct NpcSystem {
+    std::vector<float>   x, z;          //position on the ground plane
+    std::vector<uint8_t> state;         //NpcState
+    std::vector<int>     health;
+    std::vector<int>     weapon;
+    std::vector<uint8_t> interval;      //current tick interval in frames
+    std::vector<uint8_t> phase;         //stagger offset of the tick frames
+    std::vector<float>   elapsed;       //seconds since the last tick
+    std::vector<float>   tick_dt;       //seconds the current tick covers, valid for NPCs in due
+
+    std::vector<int> batches[NPC_NUM_STATES];   //NPCs due this frame, by state
+    std::vector<int> due;                       //all NPCs due this frame
+    NpcLodSettings lod;
+    uint32_t frame = 0;
+
+    int size() const { return (int)x.size(); }
+
+    void clear() {
+        x.clear(); z.clear();
+        state.clear(); health.clear(); weapon.clear();
+        interval.clear(); phase.clear(); elapsed.clear(); tick_dt.clear();
+        for (auto &b : batches) b.clear();
+        due.clear();
+        frame = 0;
+    }
+
+    int add(float x_, float z_, int health_ = 100, int weapon_ = 3) {
+        int id = size();
+        x.push_back(x_);
+        z.push_back(z_);
+        state.push_back(NPC_IDLE);
+        health.push_back(health_);
+        weapon.push_back(weapon_);
+        interval.push_back(1);
+        //golden ratio steps spread consecutive ids evenly over any interval
+        phase.push_back((uint8_t)((id * 157) & 0xff));
+        elapsed.push_back(0.0f);
+        tick_dt.push_back(0.0f);
+        return id;
+    }
+
+    bool alive(int i) const { return state[i] != NPC_DEAD; }
+
+    //returns true if this hit killed the NPC
+    bool damage(int i, int amount) {
+        if (!alive(i)) return false;
+        health[i] -= amount;
+        if (health[i] > 0) return false;
+        health[i] = 0;
+        state[i] = NPC_DEAD;
+        return true;
+    }
+
+    int tick_interval(float distance) const {
+        if (distance <= lod.near_distance) return 1;
+        if (distance <= lod.mid_distance) return lod.mid_interval;
+        return lod.far_interval;
+    }
+
+    //advance one frame: pick the NPCs that tick now and group them by state
+    //a state may change during the frame, call group_by_state() again before running the batches
+    void schedule(float player_x, float player_z, float dt) {
+        frame++;
+        due.clear();
+        int n = size();
+        for (int i = 0; i < n; i++) {
+            if (state[i] == NPC_DEAD) continue;
+            elapsed[i] += dt;
+            float distance = std::max(std::abs(x[i] - player_x), std::abs(z[i] - player_z));
+            int every = tick_interval(distance);
+            interval[i] = (uint8_t)every;
+            if ((frame + phase[i]) % every == 0) {
+                tick_dt[i] = elapsed[i];
+                elapsed[i] = 0.0f;
+                due.push_back(i);
+            }
+        }
+        group_by_state();
+    }
+
+    void group_by_state() {
+        for (auto &b : batches) b.clear();
+        for (int i : due) batches[state[i]].push_back(i);
+    }
+};
@@ -0,0 +1,160 @@
+#pragma once
+
+#include <string>
+#include <climits>
+#include <unordered_map>
+
+#include "grid.h"
+#include "indexed_heap.h"
+#include "landmarks.h"
+
+
+enum SearchStatus { SEARCH_IN_PROGRESS, SEARCH_FOUND, SEARCH_NOT_FOUND };
+
+
+//octile distance matching the straight weight*10 / diagonal weight*14 step costs
+//scaled by the cheapest cell in the grid so that it never overestimates
+inline float octile_heuristic(const NavGrid &grid, int a, int b) {
+    int dx = std::abs(grid.x_of(a) - grid.x_of(b));
+    int dy = std::abs(grid.y_of(a) - grid.y_of(b));
+    return grid.min_cost * (std::max(dx, dy) + (NAV_DIAGONAL_FACTOR - 1.0f) * std::min(dx, dy));
+}
+
+
+//Reusable state of a grid search.
+//The flat per-cell arrays are allocated once per grid size. Instead of clearing them,
+//every search bumps the generation and a cell only counts as visited if its stamp matches.
+//The open list is an indexed heap, so a cheaper path to a cell is a decrease-key, not a duplicate.
+struct AStarContext {
+    std::vector<float>    g;            //cost from start
+    std::vector<int>      parent;       //predecessor index on the best known path
+    std::vector<uint32_t> stamp;        //generation in which g and parent were written
+    uint32_t              generation = 0;
+    IndexedHeap<float>    open;
+    int start = -1;
+    int goal = -1;
+    int expanded = 0;                   //number of cells expanded by the last search
+    SearchStatus status = SEARCH_NOT_FOUND;
+    bool bounded = false;               //if set, a_star_run does not leave bounds
+    GridRect bounds;
+    const Landmarks *landmarks = nullptr;   //optional ALT tables, used while valid for the searched grid
+    bool alt = false;                   //landmarks are used by the current search
+
+    void resize(int num_cells) {
+        g.assign(num_cells, 0.0f);
+        parent.assign(num_cells, -1);
+        stamp.assign(num_cells, 0);
+        open.resize(num_cells);
+        generation = 0;
+    }
+
+    bool visited(int idx) const { return stamp[idx] == generation; }
+
+    void set(int idx, float cost, int par) {
+        g[idx] = cost;
+        parent[idx] = par;
+        stamp[idx] = generation;
+    }
+
+    //prepare a new search from start_ to goal_ without touching the per-cell arrays
+    //an optional rectangle keeps the search inside, e.g. inside one HPA* cluster
+    void begin(const NavGrid &grid, int start_, int goal_, const GridRect *bounds_ = nullptr) {
+        if ((int)g.size() != grid.size()) resize(grid.size());
+        if (++generation == 0) {                        //wrapped around, old stamps could alias
+            std::fill(stamp.begin(), stamp.end(), 0);
+            generation = 1;
+        }
+        open.clear();
+        start = start_;
+        goal = goal_;
+        expanded = 0;
+        bounded = bounds_ != nullptr;
+        if (bounded) bounds = *bounds_;
+        alt = landmarks != nullptr && landmarks->valid(grid);
+        set(start, 0.0f, start);
+        status = SEARCH_IN_PROGRESS;
+    }
+
+    //estimated cost from idx to the goal, octile distance tightened by the landmarks if available
+    float heuristic(const NavGrid &grid, int idx) const {
+        float h = octile_heuristic(grid, idx, goal);
+        return alt ? std::max(h, landmarks->lower_bound(idx, goal)) : h;
+    }
+
+    //write the found path from start to goal into path
+    //parents may be several cells apart (jump points), straight or diagonal gaps are filled in
+    void extract_path(const NavGrid &grid, std::vector<Cell> &path) const {
+        path.clear();
+        if (status != SEARCH_FOUND) return;
+
+        int current = goal;
+        path.push_back(grid.cell(current));
+        while (current != start) {
+            int p = parent[current];
+            int dx = (grid.x_of(p) > grid.x_of(current)) - (grid.x_of(p) < grid.x_of(current));
+            int dy = (grid.y_of(p) > grid.y_of(current)) - (grid.y_of(p) < grid.y_of(current));
+            int step = dy * grid.width + dx;
+            while (current != p) {
+                current += step;
+                path.push_back(grid.cell(current));
+            }
+        }
+        std::reverse(path.begin(), path.end());
+    }
+};
+
+
+//continue a search started with AStarContext::begin for at most max_expansions cells
+//returns SEARCH_IN_PROGRESS if the budget ran out before the search finished
+inline SearchStatus a_star_run(const NavGrid &grid, AStarContext &ctx, int max_expansions = INT_MAX) {
+    if (ctx.status != SEARCH_IN_PROGRESS) return ctx.status;
+
+    while (!ctx.open.empty()) {
+        if (max_expansions-- <= 0) return ctx.status;
+
+        int current = ctx.open.pop();
+        if (current == ctx.goal) {
+            return ctx.status = SEARCH_FOUND;
+        }
+        ctx.expanded++;
+
+        float current_cost = ctx.g[current];
+        grid.for_each_neighbour(current, [&](int next, int dir) {
+            if (ctx.bounded && !ctx.bounds.contains(grid.x_of(next), grid.y_of(next))) return;
+            float new_cost = current_cost + grid.step_cost(next, dir);
+            if (!ctx.visited(next) || new_cost < ctx.g[next]) {
+                ctx.set(next, new_cost, current);
+                ctx.open.push(next, new_cost + ctx.heuristic(grid, next));
+            }
+        });
+    }
+    return ctx.status = SEARCH_NOT_FOUND;
+}
+
+inline SearchStatus a_star_begin(const NavGrid &grid, Cell start, Cell end, AStarContext &ctx,
+                                 const GridRect *bounds = nullptr) {
+    if (!grid.if_in_bounds(start) || !grid.passable(end)) {
+        return ctx.status = SEARCH_NOT_FOUND;
+    }
+    int s = grid.index(start);
+    int e = grid.index(end);
+    ctx.begin(grid, s, e, bounds);
+    ctx.open.push(s, ctx.heuristic(grid, s));
+    return ctx.status;
+}
+
+//A* on the navigation grid, the grid is only read, never copied
+inline SearchStatus a_star (const NavGrid &grid,
+             Cell start,
+             Cell end,
+             AStarContext &ctx) {
+    if (a_star_begin(grid, start, end, ctx) != SEARCH_IN_PROGRESS) return ctx.status;
+    return a_star_run(grid, ctx);
+}
+
+inline void print_path(const std::vector<Cell> &path,
+               std::unordered_map<int, std::string> heights) {
+    for (const Cell &current : path) {
+        std::cout << heights[current.y] + std::to_string(current.x+1) << std::endl;
+    }
+}
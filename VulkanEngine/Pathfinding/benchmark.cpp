@@ -0,0 +1,567 @@
+//Pathfinding benchmark
+//Runs seeded batches of random queries with every search mode the game uses, on the shipped
+//level layout and on synthetic random and maze maps of several sizes, and prints one JSON
+//document with nodes expanded, queries per second, p50/p99 latency and memory per run.
+//Only the pathfinding headers and the thread pool are linked, no Vulkan or GLFW.
+//
+//On the level layout it also checks the potentially visible set: random cell pairs of the region
+//pairs the set calls hidden are traced with grid_line_of_sight, and a pair that can see each other
+//is a miss. Misses are reported in the document and make the benchmark exit with 2.
+//
+//usage: pathfinding_bench [--queries N] [--seed S] [--out file.json]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <string>
+#include <thread>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+#include "pathfinding.h"
+#include "path_service.h"
+#include "level_layout.h"
+#include "navmesh.h"
+#include "pvs.h"
+
+using namespace std;
+
+typedef chrono::steady_clock bench_clock;
+
+const int DSTAR_REPLANS = 16;        //plans per D* Lite chase, the goal moves between them
+const int SERVICE_BATCH = 64;        //requests in flight at once, about one frame of agents
+const int PVS_CHECK_PAIRS = 64;      //cell pairs traced per region pair the PVS calls hidden
+
+
+struct BenchMap {
+    string name;
+    NavGrid grid;
+    vector<NavCollider> colliders;      //geometry the grid was baked from, empty for synthetic maps
+};
+
+struct BenchQuery {
+    Cell start, goal;
+};
+
+struct BenchResult {
+    string map;
+    string mode;
+    int queries = 0;
+    int found = 0;
+    double prep_ms = 0.0;            //one-off work per map, e.g. building the jump table
+    double total_ms = 0.0;
+    double p50_us = 0.0, p99_us = 0.0;
+    double mean_expanded = 0.0;      //-1 if the mode cannot report it
+    size_t memory_bytes = 0;         //search structures owned by the mode after the run
+    long peak_rss_kb = 0;            //peak resident set of the process so far
+};
+
+//cell pairs with a line of sight in region pairs the PVS calls hidden
+struct PvsCheck {
+    int hidden_pairs = 0;            //region pairs a < b the set calls hidden
+    int traced = 0;                  //cell pairs traced in them
+    int misses = 0;
+};
+
+
+//peak resident set size of the process in KB
+static long peak_rss_kb() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS pmc;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc))) return 0;
+    return (long)(pmc.PeakWorkingSetSize / 1024);
+#else
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+    return (long)(usage.ru_maxrss / 1024);     //bytes on macOS
+#else
+    return (long)usage.ru_maxrss;              //KB on Linux
+#endif
+#endif
+}
+
+static double elapsed_us(bench_clock::time_point from, bench_clock::time_point to) {
+    return chrono::duration<double, micro>(to - from).count();
+}
+
+template<typename T>
+static size_t bytes(const vector<T> &v) {
+    return v.capacity() * sizeof(T);
+}
+
+template<typename Key>
+static size_t bytes(const IndexedHeap<Key> &h) {
+    return bytes(h.heap) + bytes(h.pos);
+}
+
+static size_t bytes(const AStarContext &ctx) {
+    return bytes(ctx.g) + bytes(ctx.parent) + bytes(ctx.stamp) + bytes(ctx.open);
+}
+
+static size_t bytes(const JumpTable &table) {
+    size_t n = 0;
+    for (const auto &d : table.dist) n += bytes(d);
+    return n;
+}
+
+//the public graph only, the scratch arrays of the abstract search are not visible
+static size_t bytes(const HpaGraph &hpa) {
+    size_t n = bytes(hpa.clusters) + bytes(hpa.nodes) + bytes(hpa.free_nodes);
+    for (const HpaCluster &c : hpa.clusters) n += bytes(c.nodes) + bytes(c.border[0]) + bytes(c.border[1]);
+    for (const HpaNode &node : hpa.nodes) n += bytes(node.edges);
+    return n;
+}
+
+static size_t bytes(const FlowField &field) {
+    return bytes(field.front.dist) + bytes(field.front.dir) + bytes(field.back.dist) + bytes(field.back.dir) + bytes(field.open);
+}
+
+static size_t bytes(const PotentiallyVisibleSet &pvs) {
+    return pvs.memory_bytes();
+}
+
+static size_t bytes(const DStarLite &planner) {
+    return bytes(planner.g) + bytes(planner.rhs) + bytes(planner.path) + bytes(planner.open);
+}
+
+
+//maps
+
+//level one baked from its colliders, like the game does on a cache miss
+static BenchMap level_map() {
+    BenchMap map{ "level", NavGrid(), level_one_colliders() };
+    nav_bake(map.grid, NavBakeSettings(), map.colliders);
+    return map;
+}
+
+//a quarter of the cells are walls, plus patches of weighted ground that JPS has to expand
+static BenchMap random_map(int size, mt19937 &rng) {
+    BenchMap map{ "random_" + to_string(size), NavGrid(size, size), {} };
+    uniform_int_distribution<int> coord(0, size - 1);
+    uniform_real_distribution<float> chance(0.0f, 1.0f);
+    for (int y = 0; y < size; y++) {
+        for (int x = 0; x < size; x++) {
+            if (chance(rng) < 0.25f) map.grid.add_wall(x, y);
+        }
+    }
+    uniform_int_distribution<int> extent(2, max(2, size / 16));
+    for (int patch = 0; patch < size / 8; patch++) {
+        int x0 = coord(rng), y0 = coord(rng);
+        int w = extent(rng), h = extent(rng);
+        double weight = chance(rng) < 0.5f ? 2.0 : 3.0;
+        for (int y = y0; y < min(y0 + h, size); y++) {
+            for (int x = x0; x < min(x0 + w, size); x++) {
+                map.grid.add_weight(x, y, weight);
+            }
+        }
+    }
+    return map;
+}
+
+//perfect maze carved by a randomized depth-first search, corridors 3 cells wide
+static BenchMap maze_map(int rooms, mt19937 &rng) {
+    const int pitch = 4;
+    int size = rooms * pitch + 1;
+    BenchMap map{ "maze_" + to_string(size), NavGrid(size, size), {} };
+    map.grid.add_wall_rect(0, 0, size - 1, size - 1);
+
+    vector<bool> seen(rooms * rooms, false);
+    vector<int> stack{ 0 };
+    seen[0] = true;
+    auto carve = [&](int room) {
+        int x = (room % rooms) * pitch + 1, y = (room / rooms) * pitch + 1;
+        for (int cy = y; cy < y + pitch - 1; cy++) {
+            for (int cx = x; cx < x + pitch - 1; cx++) map.grid.remove_wall(cx, cy);
+        }
+    };
+    carve(0);
+    while (!stack.empty()) {
+        int room = stack.back();
+        int rx = room % rooms, ry = room / rooms;
+        int options[4], count = 0;
+        for (int d = 0; d < 4; d++) {
+            int nx = rx + NAV_DIR_X[d], ny = ry + NAV_DIR_Y[d];
+            if (nx >= 0 && ny >= 0 && nx < rooms && ny < rooms && !seen[ny * rooms + nx]) options[count++] = d;
+        }
+        if (count == 0) {
+            stack.pop_back();
+            continue;
+        }
+        int d = options[uniform_int_distribution<int>(0, count - 1)(rng)];
+        int next = (ry + NAV_DIR_Y[d]) * rooms + rx + NAV_DIR_X[d];
+        seen[next] = true;
+        carve(next);
+        //open the wall between the two rooms
+        int x = rx * pitch + 1, y = ry * pitch + 1;
+        int wx = NAV_DIR_X[d] > 0 ? x + pitch - 1 : NAV_DIR_X[d] < 0 ? x - 1 : -1;
+        int wy = NAV_DIR_Y[d] > 0 ? y + pitch - 1 : NAV_DIR_Y[d] < 0 ? y - 1 : -1;
+        for (int k = 0; k < pitch - 1; k++) {
+            if (wx >= 0) map.grid.remove_wall(wx, y + k);
+            else map.grid.remove_wall(x + k, wy);
+        }
+        stack.push_back(next);
+    }
+    return map;
+}
+
+static Cell random_passable(const NavGrid &grid, mt19937 &rng) {
+    uniform_int_distribution<int> idx(0, grid.size() - 1);
+    while (true) {
+        int i = idx(rng);
+        if (!grid.blocked(i)) return Cell(grid.x_of(i), grid.y_of(i));
+    }
+}
+
+static vector<BenchQuery> make_queries(const NavGrid &grid, int count, mt19937 &rng) {
+    vector<BenchQuery> queries(count);
+    for (BenchQuery &q : queries) {
+        q.start = random_passable(grid, rng);
+        q.goal = random_passable(grid, rng);
+    }
+    return queries;
+}
+
+
+//runs
+
+static void finish(BenchResult &r, vector<double> &latency, double expanded_sum) {
+    r.queries = (int)latency.size();
+    sort(latency.begin(), latency.end());
+    auto percentile = [&](double p) {
+        if (latency.empty()) return 0.0;
+        return latency[min(latency.size() - 1, (size_t)(p * (latency.size() - 1) + 0.5))];
+    };
+    r.p50_us = percentile(0.50);
+    r.p99_us = percentile(0.99);
+    r.mean_expanded = expanded_sum < 0.0 ? -1.0 : (r.queries > 0 ? expanded_sum / r.queries : 0.0);
+    r.peak_rss_kb = peak_rss_kb();
+}
+
+//A*, JPS and HPA* through the same find_path the game calls, with alt set guided by landmarks
+static BenchResult run_search(const BenchMap &map, const vector<BenchQuery> &queries, PathMode mode, bool alt = false) {
+    static const char *names[] = { "astar", "jps", "hpa" };
+    BenchResult r;
+    r.map = map.name;
+    r.mode = string(names[mode]) + (alt ? "_alt" : "");
+
+    JumpTable table;
+    HpaGraph hpa;
+    Landmarks landmarks;
+    auto t0 = bench_clock::now();
+    if (mode == PATH_JPS) table.build(map.grid);
+    if (mode == PATH_HPA) hpa.build(map.grid);
+    if (alt) landmarks.build(map.grid);
+    r.prep_ms = elapsed_us(t0, bench_clock::now()) / 1000.0;
+
+    AStarContext ctx;
+    ctx.landmarks = alt ? &landmarks : nullptr;
+    vector<double> latency;
+    double expanded = 0.0;
+    auto begin = bench_clock::now();
+    for (const BenchQuery &q : queries) {
+        auto start = bench_clock::now();
+        SearchStatus status = find_path(map.grid, q.start, q.goal, ctx, mode, &table, &hpa);
+        latency.push_back(elapsed_us(start, bench_clock::now()));
+        r.found += status == SEARCH_FOUND;
+        expanded += ctx.expanded;
+    }
+    r.total_ms = elapsed_us(begin, bench_clock::now()) / 1000.0;
+    r.memory_bytes = bytes(ctx) + bytes(table) + bytes(hpa) + landmarks.memory_bytes();
+    finish(r, latency, expanded);
+    return r;
+}
+
+//polygon A* plus funnel on a navmesh of the map's colliders, between the query cell centers
+static BenchResult run_navmesh(const BenchMap &map, const vector<BenchQuery> &queries) {
+    BenchResult r;
+    r.map = map.name;
+    r.mode = "navmesh";
+
+    NavMesh mesh;
+    auto t0 = bench_clock::now();
+    mesh.build(NavBakeSettings(), map.colliders);
+    r.prep_ms = elapsed_us(t0, bench_clock::now()) / 1000.0;
+
+    vector<NavPoint> path;
+    vector<double> latency;
+    double expanded = 0.0;
+    auto begin = bench_clock::now();
+    for (const BenchQuery &q : queries) {
+        NavPoint start{ q.start.x + 0.5f, q.start.y + 0.5f };
+        NavPoint goal{ q.goal.x + 0.5f, q.goal.y + 0.5f };
+        auto t = bench_clock::now();
+        bool found = mesh.find_path(start, goal, path);
+        latency.push_back(elapsed_us(t, bench_clock::now()));
+        r.found += found;
+        expanded += mesh.expanded;
+    }
+    r.total_ms = elapsed_us(begin, bench_clock::now()) / 1000.0;
+    r.memory_bytes = mesh.memory_bytes();
+    finish(r, latency, expanded);
+    return r;
+}
+
+//one full field per query toward its goal, then the walk from its start
+static BenchResult run_flow_field(const BenchMap &map, const vector<BenchQuery> &queries) {
+    BenchResult r;
+    r.map = map.name;
+    r.mode = "flow_field";
+
+    FlowField field;
+    vector<double> latency;
+    double expanded = 0.0;
+    auto begin = bench_clock::now();
+    for (const BenchQuery &q : queries) {
+        auto start = bench_clock::now();
+        field.update(map.grid, q.goal);
+        int idx = map.grid.index(q.start);
+        int goal = map.grid.index(q.goal);
+        for (int steps = 0; idx >= 0 && idx != goal && steps < map.grid.size(); steps++) {
+            idx = field.next(map.grid, idx);
+        }
+        latency.push_back(elapsed_us(start, bench_clock::now()));
+        r.found += idx == goal;
+        expanded += field.expanded;
+    }
+    r.total_ms = elapsed_us(begin, bench_clock::now()) / 1000.0;
+    r.memory_bytes = bytes(field);
+    finish(r, latency, expanded);
+    return r;
+}
+
+//chases: each query starts a fresh planner, which then replans while the chaser walks a few
+//cells along its path and the goal wanders, every plan() counts as one query
+static BenchResult run_dstar_lite(const BenchMap &map, const vector<BenchQuery> &queries, mt19937 &rng) {
+    BenchResult r;
+    r.map = map.name;
+    r.mode = "dstar_lite";
+
+    const NavGrid &grid = map.grid;
+    DStarLite planner;
+    size_t memory = 0;
+    vector<double> latency;
+    double expanded = 0.0;
+    uniform_int_distribution<int> dir(0, NAV_NUM_DIRS - 1);
+    auto begin = bench_clock::now();
+    for (size_t i = 0; i * DSTAR_REPLANS < queries.size(); i++) {
+        planner = DStarLite();
+        Cell start = queries[i].start;
+        Cell goal = queries[i].goal;
+        for (int plan = 0; plan < DSTAR_REPLANS && latency.size() < queries.size(); plan++) {
+            auto t = bench_clock::now();
+            SearchStatus status = planner.plan(grid, start, goal);
+            latency.push_back(elapsed_us(t, bench_clock::now()));
+            r.found += status == SEARCH_FOUND;
+            expanded += planner.expanded;
+            memory = max(memory, bytes(planner));
+            if (status != SEARCH_FOUND) break;
+
+            for (int step = 0; step < 4 && planner.next(grid, start, start); step++) {}
+            for (int step = 0; step < 2; step++) {
+                int d = dir(rng);
+                Cell moved(goal.x + NAV_DIR_X[d], goal.y + NAV_DIR_Y[d]);
+                if (grid.passable(moved)) goal = moved;
+            }
+        }
+    }
+    r.total_ms = elapsed_us(begin, bench_clock::now()) / 1000.0;
+    r.memory_bytes = memory;
+    finish(r, latency, expanded);
+    return r;
+}
+
+//PathService on a thread pool, SERVICE_BATCH requests in flight at a time
+//latency is from request() to the delivered result, expansions are not reported back
+static BenchResult run_service(const BenchMap &map, const vector<BenchQuery> &queries, ThreadPool &pool) {
+    BenchResult r;
+    r.map = map.name;
+    r.mode = "service_jps";
+
+    auto t0 = bench_clock::now();
+    JumpTable table;
+    table.build(map.grid);
+    PathService service(&pool, PATH_JPS);
+    service.set_grid(map.grid, &table);
+    r.prep_ms = elapsed_us(t0, bench_clock::now()) / 1000.0;
+
+    struct Pending {
+        PathTicket ticket;
+        bench_clock::time_point issued;
+    };
+    vector<Pending> pending;
+    vector<Cell> path;
+    vector<double> latency;
+    size_t next = 0;
+    auto begin = bench_clock::now();
+    while (next < queries.size() || !pending.empty()) {
+        while (next < queries.size() && pending.size() < (size_t)SERVICE_BATCH) {
+            pending.push_back({ service.request(queries[next].start, queries[next].goal), bench_clock::now() });
+            next++;
+        }
+        service.deliver();
+        for (size_t i = 0; i < pending.size();) {
+            SearchStatus status;
+            if (service.collect(pending[i].ticket, path, status)) {
+                latency.push_back(elapsed_us(pending[i].issued, bench_clock::now()));
+                r.found += status == SEARCH_FOUND;
+                pending[i] = pending.back();
+                pending.pop_back();
+            } else {
+                i++;
+            }
+        }
+        this_thread::yield();
+    }
+    r.total_ms = elapsed_us(begin, bench_clock::now()) / 1000.0;
+    r.memory_bytes = bytes(table);
+    finish(r, latency, -1.0);
+    return r;
+}
+
+//the set lookup for every query, then the regression check of its hidden region pairs
+//the check draws its cells from its own generator, so the maps after this one stay the same
+static BenchResult run_pvs(const BenchMap &map, const vector<BenchQuery> &queries, ThreadPool &pool, unsigned seed, PvsCheck &check) {
+    BenchResult r;
+    r.map = map.name;
+    r.mode = "pvs";
+
+    PotentiallyVisibleSet pvs;
+    auto t0 = bench_clock::now();
+    pvs.build(map.grid, 32, &pool);
+    r.prep_ms = elapsed_us(t0, bench_clock::now()) / 1000.0;
+
+    vector<double> latency;
+    auto begin = bench_clock::now();
+    for (const BenchQuery &q : queries) {
+        auto t = bench_clock::now();
+        bool visible = pvs.is_potentially_visible(map.grid, q.start, q.goal);
+        latency.push_back(elapsed_us(t, bench_clock::now()));
+        r.found += visible;
+    }
+    r.total_ms = elapsed_us(begin, bench_clock::now()) / 1000.0;
+    r.memory_bytes = bytes(pvs);
+    finish(r, latency, -1.0);
+
+    //a random passable cell of region, false if none turned up
+    mt19937 rng(seed);
+    auto cell_in = [&](int region, Cell &c) {
+        int x0 = region % pvs.regions_x * pvs.region_size, y0 = region / pvs.regions_x * pvs.region_size;
+        uniform_int_distribution<int> dx(0, min(pvs.region_size, map.grid.width - x0) - 1);
+        uniform_int_distribution<int> dy(0, min(pvs.region_size, map.grid.height - y0) - 1);
+        for (int tries = 0; tries < 64; tries++) {
+            c = Cell(x0 + dx(rng), y0 + dy(rng));
+            if (map.grid.passable(c)) return true;
+        }
+        return false;
+    };
+    int n = pvs.num_regions();
+    for (int a = 0; a < n; a++) {
+        for (int b = a + 1; b < n; b++) {
+            if (pvs.is_potentially_visible(a, b)) continue;
+            check.hidden_pairs++;
+            for (int k = 0; k < PVS_CHECK_PAIRS; k++) {
+                Cell p, q;
+                if (!cell_in(a, p) || !cell_in(b, q)) break;
+                check.traced++;
+                check.misses += grid_line_of_sight(map.grid, p, q);
+            }
+        }
+    }
+    return r;
+}
+
+
+//output
+
+static void write_json(ostream &out, const vector<BenchResult> &results, const PvsCheck &check, int queries, unsigned seed, size_t threads) {
+    out << "{\n";
+    out << "  \"seed\": " << seed << ",\n";
+    out << "  \"queries\": " << queries << ",\n";
+    out << "  \"threads\": " << threads << ",\n";
+    out << "  \"runs\": [\n";
+    for (size_t i = 0; i < results.size(); i++) {
+        const BenchResult &r = results[i];
+        char line[512];
+        snprintf(line, sizeof(line),
+                 "    { \"map\": \"%s\", \"mode\": \"%s\", \"queries\": %d, \"found\": %d, "
+                 "\"prep_ms\": %.3f, \"total_ms\": %.3f, \"qps\": %.1f, \"p50_us\": %.2f, \"p99_us\": %.2f, "
+                 "\"nodes_expanded\": %.1f, \"memory_bytes\": %zu, \"peak_rss_kb\": %ld }%s\n",
+                 r.map.c_str(), r.mode.c_str(), r.queries, r.found,
+                 r.prep_ms, r.total_ms, r.total_ms > 0.0 ? r.queries * 1000.0 / r.total_ms : 0.0, r.p50_us, r.p99_us,
+                 r.mean_expanded, r.memory_bytes, r.peak_rss_kb, i + 1 < results.size() ? "," : "");
+        out << line;
+    }
+    out << "  ],\n";
+    out << "  \"pvs_check\": { \"hidden_pairs\": " << check.hidden_pairs << ", \"traced\": " << check.traced
+        << ", \"misses\": " << check.misses << " },\n";
+    out << "  \"peak_rss_kb\": " << peak_rss_kb() << "\n";
+    out << "}\n";
+}
+
+
+int main(int argc, char *argv[]) {
+    int num_queries = 500;
+    unsigned seed = 12345;
+    string out_file;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--queries") && i + 1 < argc) num_queries = max(1, atoi(argv[++i]));
+        else if (!strcmp(argv[i], "--seed") && i + 1 < argc) seed = (unsigned)strtoul(argv[++i], nullptr, 10);
+        else if (!strcmp(argv[i], "--out") && i + 1 < argc) out_file = argv[++i];
+        else {
+            fprintf(stderr, "usage: %s [--queries N] [--seed S] [--out file.json]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    //every map and query set only depends on the seed, maps are ordered from small to large
+    mt19937 rng(seed);
+    vector<BenchMap> maps;
+    maps.push_back(random_map(128, rng));
+    maps.push_back(maze_map(32, rng));
+    maps.push_back(level_map());
+    maps.push_back(random_map(256, rng));
+    maps.push_back(maze_map(64, rng));
+    maps.push_back(random_map(512, rng));
+    maps.push_back(maze_map(128, rng));
+
+    ThreadPool pool(0);
+    vector<BenchResult> results;
+    PvsCheck check;
+    for (const BenchMap &map : maps) {
+        vector<BenchQuery> queries = make_queries(map.grid, num_queries, rng);
+        fprintf(stderr, "%s (%dx%d)\n", map.name.c_str(), map.grid.width, map.grid.height);
+        results.push_back(run_search(map, queries, PATH_ASTAR));
+        results.push_back(run_search(map, queries, PATH_JPS));
+        results.push_back(run_search(map, queries, PATH_HPA));
+        results.push_back(run_search(map, queries, PATH_ASTAR, true));
+        results.push_back(run_search(map, queries, PATH_JPS, true));
+        results.push_back(run_search(map, queries, PATH_HPA, true));
+        if (!map.colliders.empty()) results.push_back(run_navmesh(map, queries));
+        if (!map.colliders.empty()) results.push_back(run_pvs(map, queries, pool, seed, check));
+        results.push_back(run_flow_field(map, queries));
+        results.push_back(run_dstar_lite(map, queries, rng));
+        results.push_back(run_service(map, queries, pool));
+    }
+
+    if (out_file.empty()) {
+        write_json(cout, results, check, num_queries, seed, pool.threadCount());
+    } else {
+        ofstream out(out_file);
+        write_json(out, results, check, num_queries, seed, pool.threadCount());
+    }
+    if (check.misses > 0) {
+        fprintf(stderr, "pvs: %d of %d traced cell pairs see each other in regions the set calls hidden\n", check.misses, check.traced);
+        return 2;
+    }
+    return 0;
+}
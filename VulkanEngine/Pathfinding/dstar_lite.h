@@ -0,0 +1,226 @@
+#pragma once
+
+#include <algorithm>
+#include <limits>
+#include <utility>
+
+#include "astar.h"
+
+//D* Lite (Koenig & Likhachev 2002) on the navigation grid, rooted at the chaser as in
+//Moving Target D* Lite (Sun, Yeoh & Koenig 2010).
+//The search grows from a root cell where the chasing agent stood, g[s] is the cost of the best
+//path from the root to s, and the heuristic focuses it on the goal (the player). The planner keeps
+//g/rhs and its open list between calls, so a later plan() only repairs:
+// - the goal moving is absorbed by the km key offset, only the cells around the new goal are touched,
+// - the agent walking along the path moves nothing: every part of a shortest path is a shortest path,
+//   so the agent follows the rest of the path from the root; only if it leaves the path the
+//   planner is rooted at its new cell with a fresh search,
+// - wall/weight changes are read from NavGrid::change_log and update the cells around them.
+//Each planner owns two floats per cell, so it suits a handful of chasers; many agents with
+//one target should share a FlowField instead.
+
+
+typedef std::pair<float, float> DStarKey;
+constexpr float DSTAR_INF = std::numeric_limits<float>::infinity();
+
+struct DStarLite {
+    std::vector<float> g;
+    std::vector<float> rhs;                 //one-step lookahead of g
+    std::vector<int> path;                  //current path from the root to the goal
+    IndexedHeap<DStarKey> open;
+    int root = -1;                          //cell the search grows from
+    int start = -1;                         //cell of the agent, on path
+    int goal = -1;
+    int last = -1;                          //goal at the time km was last updated
+    float km = 0.0f;
+    uint32_t version = 0;                   //grid version the state is consistent with
+    uint8_t min_cost = 0;                   //heuristic scale the keys were computed with
+    int width = 0, height = 0;
+    int expanded = 0;                       //vertices processed by the last plan()
+    bool rooted = false;                    //whether the last plan() had to start a fresh search
+    SearchStatus status = SEARCH_NOT_FOUND;
+
+    //(re)plan from start_ to goal_, reusing everything that is still valid
+    SearchStatus plan(const NavGrid &grid, Cell start_, Cell goal_) {
+        expanded = 0;
+        rooted = false;
+        if (!grid.passable(start_) || !grid.passable(goal_)) return status = SEARCH_NOT_FOUND;
+        int s = grid.index(start_);
+        int e = grid.index(goal_);
+
+        //keys are only comparable while the heuristic scale stays the same
+        bool fresh = root < 0 || width != grid.width || height != grid.height || min_cost != grid.min_cost;
+        changed.clear();
+        if (!fresh && version != grid.version && !grid.changes_since(version, changed)) fresh = true;
+        //the agent left the path, or found none: the tree of the old root is no use to it
+        if (!fresh && (status != SEARCH_FOUND || std::find(path.begin(), path.end(), s) == path.end())) fresh = true;
+
+        if (fresh) {
+            reset(grid, s, e);
+        } else {
+            start = s;
+            if (e != goal) {
+                km += octile_heuristic(grid, last, e);
+                goal = last = e;
+            }
+            for (const GridRect &r : changed) {
+                //the cells themselves and every neighbour whose rhs reads them
+                for (int y = std::max(r.y0 - 1, 0); y <= std::min(r.y1 + 1, grid.height - 1); y++) {
+                    for (int x = std::max(r.x0 - 1, 0); x <= std::min(r.x1 + 1, grid.width - 1); x++) {
+                        update_vertex(grid, grid.index(x, y));
+                    }
+                }
+            }
+            version = grid.version;
+        }
+
+        search(grid);
+        if (!rooted && (status != SEARCH_FOUND || std::find(path.begin(), path.end(), start) == path.end())) {
+            //a wall change moved the path away from the agent or cut it off from the root
+            reset(grid, s, e);
+            search(grid);
+        }
+        return status;
+    }
+
+    //cost of the current path from the agent to the goal
+    float path_cost() const { return status == SEARCH_FOUND ? rhs[goal] - rhs[start] : DSTAR_INF; }
+
+    //next cell from idx toward the goal, -1 if idx is not on the current path or is the goal
+    int next(const NavGrid &grid, int idx) const {
+        (void)grid;
+        for (size_t i = 0; i + 1 < path.size(); i++) {
+            if (path[i] == idx) return path[i + 1];
+        }
+        return -1;
+    }
+
+    bool next(const NavGrid &grid, Cell from, Cell &to) const {
+        if (!grid.if_in_bounds(from)) return false;
+        int n = next(grid, grid.index(from));
+        if (n < 0) return false;
+        to = grid.cell(n);
+        return true;
+    }
+
+    //write the current path from start to goal into path_
+    void extract_path(const NavGrid &grid, std::vector<Cell> &path_) const {
+        path_.clear();
+        if (status != SEARCH_FOUND) return;
+        auto at = std::find(path.begin(), path.end(), start);
+        for (; at != path.end(); ++at) path_.push_back(grid.cell(*at));
+    }
+
+private:
+    std::vector<GridRect> changed;
+
+    DStarKey key(const NavGrid &grid, int s) const {
+        float m = std::min(g[s], rhs[s]);
+        return { m + octile_heuristic(grid, goal, s) + km, m };
+    }
+
+    void reset(const NavGrid &grid, int s, int e) {
+        width = grid.width;
+        height = grid.height;
+        min_cost = grid.min_cost;
+        version = grid.version;
+        g.assign(grid.size(), DSTAR_INF);
+        rhs.assign(grid.size(), DSTAR_INF);
+        open.resize(grid.size());
+        km = 0.0f;
+        root = start = s;
+        goal = last = e;
+        rhs[root] = 0.0f;
+        open.push(root, key(grid, root));
+        rooted = true;
+    }
+
+    void search(const NavGrid &grid) {
+        compute(grid);
+        status = rhs[goal] < DSTAR_INF ? SEARCH_FOUND : SEARCH_NOT_FOUND;
+        trace(grid);
+    }
+
+    //follow the cheapest predecessors back from the goal to the root
+    //ties go to the predecessor closest to the agent, so the path keeps passing through it
+    void trace(const NavGrid &grid) {
+        path.clear();
+        if (status != SEARCH_FOUND) return;
+        int current = goal;
+        path.push_back(current);
+        while (current != root && (int)path.size() <= grid.size()) {
+            int best = -1;
+            float best_cost = DSTAR_INF, best_h = DSTAR_INF;
+            grid.for_each_neighbour(current, [&](int n, int dir) {
+                //stepping from n onto current is diagonal exactly if dir is
+                float c = g[n] + grid.step_cost(current, dir);
+                float h = octile_heuristic(grid, n, start);
+                float tie = 1.0e-4f * grid.min_cost;        //routes of equal cost may differ by rounding
+                if (c < best_cost - tie || (c <= best_cost + tie && h < best_h)) {
+                    best_cost = c;
+                    best_h = h;
+                    best = n;
+                }
+            });
+            if (best < 0 || best_cost == DSTAR_INF) {
+                path.clear();
+                status = SEARCH_NOT_FOUND;
+                return;
+            }
+            current = best;
+            path.push_back(current);
+        }
+        std::reverse(path.begin(), path.end());
+    }
+
+    //recompute rhs of u from its predecessors and fix its place in the open list
+    void update_vertex(const NavGrid &grid, int u) {
+        if (u != root) {
+            float best = DSTAR_INF;
+            if (!grid.blocked(u)) {
+                grid.for_each_neighbour(u, [&](int n, int dir) {
+                    best = std::min(best, g[n] + grid.step_cost(u, dir));
+                });
+            }
+            rhs[u] = best;
+        }
+        queue(grid, u);
+    }
+
+    void queue(const NavGrid &grid, int u) {
+        if (g[u] != rhs[u]) open.push(u, key(grid, u));
+        else open.remove(u);
+    }
+
+    void compute(const NavGrid &grid) {
+        while (!open.empty() && (open.top_key() < key(grid, goal) || rhs[goal] > g[goal])) {
+            int u = open.top();
+            DStarKey k_old = open.top_key();
+            DStarKey k_new = key(grid, u);
+            expanded++;
+            if (k_old < k_new) {
+                open.push(u, k_new);
+            } else if (g[u] > rhs[u]) {
+                //overconsistent: settle u and offer it to its successors
+                g[u] = rhs[u];
+                open.remove(u);
+                grid.for_each_neighbour(u, [&](int n, int dir) {
+                    if (n == root || grid.blocked(u)) return;
+                    float c = g[u] + grid.step_cost(n, dir);
+                    if (c < rhs[n]) {
+                        rhs[n] = c;
+                        queue(grid, n);
+                    }
+                });
+            } else {
+                //underconsistent: u got more expensive, every cell that went through it looks again
+                float g_old = g[u];
+                g[u] = DSTAR_INF;
+                update_vertex(grid, u);
+                grid.for_each_neighbour(u, [&](int n, int dir) {
+                    if (n != root && rhs[n] == g_old + grid.step_cost(n, dir)) update_vertex(grid, n);
+                });
+            }
+        }
+    }
+};
@@ -0,0 +1,143 @@
+#pragma once
+
+#include <climits>
+#include <cstdlib>
+#include <limits>
+
+#include "grid.h"
+#include "indexed_heap.h"
+
+//Flow field (Dijkstra map) toward one target cell, shared by every agent chasing it.
+//One reverse Dijkstra from the target stores for each cell its cost to the target and the
+//direction of the first step, so any number of agents read their next cell in O(1).
+//
+//The field is double buffered. When the target changes cell or the grid changes, a new field
+//is integrated into the back buffer for at most a given number of cells per update, while
+//agents keep following the last complete field. The buffers swap once the new one is done.
+//A build in flight is finished even if the target moved on meanwhile, so a moving target still
+//gets a field that is at most one build old; only a grid change throws it away.
+//The flood can be limited to the cells within a radius of the target, e.g. the chase radius of
+//the agents, then a build only touches those cells and only those are reset for the next one.
+
+
+struct FlowField {
+    struct Buffer {
+        std::vector<float>   dist;      //cost of the best path to the target
+        std::vector<uint8_t> dir;       //NAV_DIR_* index of the first step, NAV_NO_DIR if none
+        std::vector<int>     touched;   //cells with a finite dist, reset by the next build
+        int target = -1;
+        int radius = INT_MAX;           //cells farther from the target on either axis are left out
+        uint32_t version = 0;           //grid version the field was integrated on
+    };
+
+    Buffer front;                       //last complete field, read by the agents
+    Buffer back;                        //field under construction
+    IndexedHeap<float> open;
+    bool building = false;
+    int expanded = 0;                   //cells settled by the last update
+
+    bool ready() const { return front.target >= 0; }
+    int target() const { return front.target; }
+
+    //true if the complete field matches target and grid
+    bool current(const NavGrid &grid, int target_) const {
+        return ready() && front.target == target_ && front.version == grid.version;
+    }
+
+    //start integrating a new field toward target_ in the back buffer, within radius cells of it
+    void begin(const NavGrid &grid, int target_, int radius = INT_MAX) {
+        if ((int)back.dist.size() != grid.size()) {
+            back.dist.assign(grid.size(), std::numeric_limits<float>::infinity());
+            back.dir.assign(grid.size(), NAV_NO_DIR);
+            back.touched.clear();
+            open.resize(grid.size());
+        } else {
+            for (int idx : back.touched) {
+                back.dist[idx] = std::numeric_limits<float>::infinity();
+                back.dir[idx] = NAV_NO_DIR;
+            }
+            back.touched.clear();
+            open.clear();
+        }
+        back.target = target_;
+        back.radius = radius;
+        back.version = grid.version;
+        back.dist[target_] = 0.0f;
+        back.touched.push_back(target_);
+        open.push(target_, 0.0f);
+        building = true;
+    }
+
+    //whether idx lies within the radius of the field under construction
+    bool in_radius(const NavGrid &grid, int idx) const {
+        if (back.radius == INT_MAX) return true;
+        return std::abs(grid.x_of(idx) - grid.x_of(back.target)) <= back.radius &&
+               std::abs(grid.y_of(idx) - grid.y_of(back.target)) <= back.radius;
+    }
+
+    //settle at most max_expansions cells, returns true once the field is complete and swapped in
+    bool run(const NavGrid &grid, int max_expansions = INT_MAX) {
+        expanded = 0;
+        if (!building) return true;
+        while (!open.empty()) {
+            if (max_expansions-- <= 0) return false;
+            int current = open.pop();
+            expanded++;
+            float current_cost = back.dist[current];
+            //a neighbour n reaches current by one step in the opposite direction,
+            //which costs entering current
+            grid.for_each_neighbour(current, [&](int n, int dir) {
+                float new_cost = current_cost + grid.step_cost(current, dir);
+                if (new_cost < back.dist[n] && in_radius(grid, n)) {
+                    if (back.dist[n] == std::numeric_limits<float>::infinity()) back.touched.push_back(n);
+                    back.dist[n] = new_cost;
+                    back.dir[n] = (uint8_t)NAV_DIR_OPPOSITE[dir];
+                    open.push(n, new_cost);
+                }
+            });
+        }
+        std::swap(front, back);
+        building = false;
+        return true;
+    }
+
+    //call once per step: continues the integration for at most max_expansions cells, and starts
+    //a new one toward target_ once the field in flight is swapped in, or at once if the grid changed
+    //radius limits the field to the cells whose x and y are at most that far from the target
+    //returns true if the front field is current
+    bool update(const NavGrid &grid, Cell target_, int max_expansions = INT_MAX, int radius = INT_MAX) {
+        if (!grid.passable(target_)) return current(grid, front.target);
+        int t = grid.index(target_);
+        if (current(grid, t)) return true;
+        if (building && back.version != grid.version) building = false;   //integrated on an old grid
+        if (!building) begin(grid, t, radius);
+        bool done = run(grid, max_expansions);
+        int used = expanded;
+        if (done && front.target != t && used < max_expansions) {      //the finished field was for an old target
+            begin(grid, t, radius);
+            run(grid, max_expansions - used);
+            used += expanded;
+        }
+        expanded = used;
+        return current(grid, t);
+    }
+
+    //O(1) next cell from idx toward the target, -1 if idx has no path or is the target
+    int next(const NavGrid &grid, int idx) const {
+        if (!ready() || (int)front.dir.size() != grid.size()) return -1;
+        uint8_t d = front.dir[idx];
+        return d == NAV_NO_DIR ? -1 : idx + grid.dir_offset[d];
+    }
+
+    bool next(const NavGrid &grid, Cell from, Cell &to) const {
+        if (!grid.if_in_bounds(from)) return false;
+        int n = next(grid, grid.index(from));
+        if (n < 0) return false;
+        to = grid.cell(n);
+        return true;
+    }
+
+    float cost_to_target(int idx) const {
+        return ready() ? front.dist[idx] : std::numeric_limits<float>::infinity();
+    }
+};
@@ -0,0 +1,294 @@
+#pragma once
+
+#include <cstdint>
+#include <cmath>
+#include <vector>
+#include <tuple>
+#include <iostream>
+#include <functional>
+#include <algorithm>
+
+//Navigation grid used by the enemy AI
+//Cells are stored row-major (index = y*width + x) in two flat arrays:
+//one step cost byte per cell and one wall bit per cell.
+//This keeps a 400x400 map at 160 KB of costs + 20 KB of walls and makes
+//every passability check a single shift and mask.
+
+struct Cell {
+    int x, y;
+    double weight;
+    Cell() {
+
+    }
+
+    Cell(Cell *cell) {
+        x = cell->x;
+        y = cell->y;
+        weight = cell->weight;
+    }
+
+    Cell(int x_, int y_, double weight_):
+    x(x_), y(y_), weight(weight_) {}
+
+    Cell(int x_, int y_):
+    x(x_), y(y_) {}
+};
+
+namespace std {
+    template <> struct hash<Cell> {
+        typedef Cell argument_type;
+        typedef std::size_t result_type;
+        std::size_t operator()(const Cell& id) const noexcept {
+            return std::hash<uint64_t>()(((uint64_t)(uint32_t)id.x << 32) | (uint32_t)id.y);
+        }
+    };
+}
+
+inline bool operator == (Cell a, Cell b) {
+    return a.x == b.x && a.y == b.y;
+}
+
+inline bool operator != (Cell a, Cell b) {
+    return a.x != b.x || a.y != b.y;
+}
+
+inline bool operator < (Cell a, Cell b) {
+  return std::tie(a.x, a.y) < std::tie(b.x, b.y);
+}
+
+
+constexpr uint8_t NAV_BASE_COST = 10;       //cost byte of a cell with weight 1.0, a step costs weight*10
+constexpr float NAV_DIAGONAL_FACTOR = 1.4f; //a diagonal step costs weight*14
+
+//the 8 neighbour directions, in the order the old Grid::get_neighbours returned them
+//0-3 are straight moves, 4-7 are diagonal moves
+constexpr int NAV_NUM_DIRS = 8;
+constexpr int NAV_DIR_X[NAV_NUM_DIRS] = { 0,  0, -1, 1, -1,  1, -1, 1 };
+constexpr int NAV_DIR_Y[NAV_NUM_DIRS] = { 1, -1,  0, 0, -1, -1,  1, 1 };
+constexpr int NAV_DIR_OPPOSITE[NAV_NUM_DIRS] = { 1, 0, 3, 2, 7, 6, 5, 4 };
+constexpr uint8_t NAV_NO_DIR = 0xff;
+
+
+//inclusive rectangle of cells
+struct GridRect {
+    int x0, y0, x1, y1;
+
+    bool contains(int x, int y) const {
+        return x0 <= x && x <= x1 && y0 <= y && y <= y1;
+    }
+
+    bool overlaps(const GridRect &r) const {
+        return x0 <= r.x1 && r.x0 <= x1 && y0 <= r.y1 && r.y0 <= y1;
+    }
+};
+
+
+//a rectangle of cells changed by the mutation that produced version
+struct GridChange {
+    uint32_t version;
+    GridRect rect;
+};
+
+constexpr size_t NAV_CHANGE_LOG_SIZE = 256;     //changes kept for incremental consumers
+
+
+struct NavGrid {
+    int width, height;
+    std::vector<uint8_t>  costs;    //row-major step cost per cell, weight*10
+    std::vector<uint64_t> walls;    //row-major wall bitset, bit set = blocked
+    int dir_offset[NAV_NUM_DIRS];   //index delta of each neighbour direction
+    uint8_t min_cost = NAV_BASE_COST;   //lower bound of all cost bytes, keeps heuristics admissible
+    int weighted_cells = 0;             //number of cells whose cost is not NAV_BASE_COST
+    std::vector<uint64_t> weighted_near;    //bit set if the cell or one of its 8 neighbours is not NAV_BASE_COST
+    uint32_t version = 0;               //incremented on every change, lets derived data detect staleness
+    std::vector<GridChange> change_log; //the last NAV_CHANGE_LOG_SIZE changes, oldest first
+
+    NavGrid(int width_ = 0, int height_ = 0)
+        : width(width_), height(height_)
+        , costs( (size_t)width_ * height_, NAV_BASE_COST )
+        , walls( ((size_t)width_ * height_ + 63) / 64, 0 )
+        , weighted_near( ((size_t)width_ * height_ + 63) / 64, 0 ) {
+        for( int d = 0; d < NAV_NUM_DIRS; ++d ) {
+            dir_offset[d] = NAV_DIR_Y[d] * width + NAV_DIR_X[d];
+        }
+    }
+
+    int size() const { return width * height; }
+    int index(int x, int y) const { return y * width + x; }
+    int index(Cell id) const { return index(id.x, id.y); }
+    int x_of(int idx) const { return idx % width; }
+    int y_of(int idx) const { return idx / width; }
+    Cell cell(int idx) const { return Cell(x_of(idx), y_of(idx), weight(idx)); }
+
+    bool if_in_bounds(int x, int y) const {
+        return 0 <= x && x < width
+            && 0 <= y && y < height;
+    }
+
+    bool if_in_bounds(Cell id) const { return if_in_bounds(id.x, id.y); }
+
+    //O(1) wall test on a valid index
+    bool blocked(int idx) const {
+        return (walls[idx >> 6] >> (idx & 63)) & 1u;
+    }
+
+    bool passable(int x, int y) const {
+        return if_in_bounds(x, y) && !blocked(index(x, y));
+    }
+
+    bool passable(Cell id) const { return passable(id.x, id.y); }
+
+    void add_wall(int x, int y) {
+        if (!if_in_bounds(x, y)) return;
+        int idx = index(x, y);
+        walls[idx >> 6] |= (uint64_t)1 << (idx & 63);
+        log_change(x, y, x, y);
+    }
+
+    void remove_wall(int x, int y) {
+        if (!if_in_bounds(x, y)) return;
+        int idx = index(x, y);
+        walls[idx >> 6] &= ~((uint64_t)1 << (idx & 63));
+        log_change(x, y, x, y);
+    }
+
+    //block all cells in the inclusive rectangle [x0,x1]x[y0,y1], clipped to the grid
+    void add_wall_rect(int x0, int y0, int x1, int y1) {
+        x0 = std::max(x0, 0); y0 = std::max(y0, 0);
+        x1 = std::min(x1, width - 1); y1 = std::min(y1, height - 1);
+        for (int y = y0; y <= y1; y++) {
+            for (int x = x0; x <= x1; x++) {
+                int idx = index(x, y);
+                walls[idx >> 6] |= (uint64_t)1 << (idx & 63);
+            }
+        }
+        log_change(x0, y0, x1, y1);
+    }
+
+    void add_weight(int x, int y, double weight) {
+        if (!if_in_bounds(x, y)) return;
+        double c = std::round(weight * NAV_BASE_COST);
+        uint8_t &cost = costs[index(x, y)];
+        weighted_cells -= cost != NAV_BASE_COST;
+        cost = (uint8_t) std::min(std::max(c, 1.0), 255.0);
+        weighted_cells += cost != NAV_BASE_COST;
+        min_cost = std::min(min_cost, cost);
+        for (int ny = y - 1; ny <= y + 1; ny++) {
+            for (int nx = x - 1; nx <= x + 1; nx++) {
+                update_weighted_near(nx, ny);
+            }
+        }
+        log_change(x, y, x, y);
+    }
+
+    bool is_weighted_near(int idx) const {
+        return (weighted_near[idx >> 6] >> (idx & 63)) & 1u;
+    }
+
+    uint8_t cost(int idx) const { return costs[idx]; }
+    bool uniform() const { return weighted_cells == 0; }
+    double weight(int idx) const { return costs[idx] / (double) NAV_BASE_COST; }
+
+    //cost of stepping onto cell idx in direction dir
+    float step_cost(int idx, int dir) const {
+        return dir < 4 ? (float)costs[idx] : costs[idx] * NAV_DIAGONAL_FACTOR;
+    }
+
+    void clear() {
+        std::fill(costs.begin(), costs.end(), NAV_BASE_COST);
+        std::fill(walls.begin(), walls.end(), 0);
+        std::fill(weighted_near.begin(), weighted_near.end(), 0);
+        min_cost = NAV_BASE_COST;
+        weighted_cells = 0;
+        log_change(0, 0, width - 1, height - 1);
+    }
+
+    //replace size and content in one go, e.g. with a baked or cached grid
+    //walls_ is a packed bitset like walls, costs_ one byte per cell or nullptr for NAV_BASE_COST everywhere
+    //the version keeps counting up, so derived data of the old content is recognised as stale
+    void assign(int width_, int height_, const uint64_t *walls_, const uint8_t *costs_) {
+        width = width_;
+        height = height_;
+        for (int d = 0; d < NAV_NUM_DIRS; ++d) {
+            dir_offset[d] = NAV_DIR_Y[d] * width + NAV_DIR_X[d];
+        }
+        size_t words = ((size_t)width * height + 63) / 64;
+        walls.assign(walls_, walls_ + words);
+        if (costs_ != nullptr) costs.assign(costs_, costs_ + (size_t)width * height);
+        else costs.assign((size_t)width * height, NAV_BASE_COST);
+        weighted_near.assign(words, 0);
+        min_cost = NAV_BASE_COST;
+        weighted_cells = 0;
+        for (uint8_t c : costs) {
+            min_cost = std::min(min_cost, c);
+            weighted_cells += c != NAV_BASE_COST;
+        }
+        if (weighted_cells > 0) {
+            for (int y = 0; y < height; y++) {
+                for (int x = 0; x < width; x++) update_weighted_near(x, y);
+            }
+        }
+        log_change(0, 0, width - 1, height - 1);
+    }
+
+    void log_change(int x0, int y0, int x1, int y1) {
+        version++;
+        if (change_log.size() >= NAV_CHANGE_LOG_SIZE) change_log.erase(change_log.begin());
+        change_log.push_back({ version, { x0, y0, x1, y1 } });
+    }
+
+    //append the rectangles changed after version since to out
+    //returns false if the log does not reach back that far, then the consumer has to rebuild
+    bool changes_since(uint32_t since, std::vector<GridRect> &out) const {
+        if (since == version) return true;
+        if (change_log.empty() || change_log.front().version > since + 1) return false;
+        for (const GridChange &c : change_log) {
+            if (c.version > since) out.push_back(c.rect);
+        }
+        return true;
+    }
+
+    //call f(neighbour_index, direction) for every passable 8-neighbour of idx
+    //no allocation, no hashing: interior cells skip the bounds checks entirely
+    template<typename F>
+    void for_each_neighbour(int idx, F&& f) const {
+        int x = x_of(idx);
+        int y = y_of(idx);
+        bool interior = x > 0 && y > 0 && x < width - 1 && y < height - 1;
+        for (int d = 0; d < NAV_NUM_DIRS; d++) {
+            if (!interior && !if_in_bounds(x + NAV_DIR_X[d], y + NAV_DIR_Y[d])) continue;
+            int n = idx + dir_offset[d];
+            if (!blocked(n)) f(n, d);
+        }
+    }
+
+    void update_weighted_near(int x, int y) {
+        if (!if_in_bounds(x, y)) return;
+        bool near = false;
+        for (int ny = std::max(y - 1, 0); ny <= std::min(y + 1, height - 1); ny++) {
+            for (int nx = std::max(x - 1, 0); nx <= std::min(x + 1, width - 1); nx++) {
+                near |= costs[index(nx, ny)] != NAV_BASE_COST;
+            }
+        }
+        int idx = index(x, y);
+        if (near) weighted_near[idx >> 6] |= (uint64_t)1 << (idx & 63);
+        else weighted_near[idx >> 6] &= ~((uint64_t)1 << (idx & 63));
+    }
+
+    void print_map() const {
+        for (int i = 0; i < width; i++) {
+            for (int j = 0; j < height; j++) {
+                double w = weight(index(i, j));
+                std::cout << w;
+                if (w == 1) {
+                    std::cout << ".0";
+                }
+                if (j != height - 1) {
+                    std::cout << " - ";
+                }
+            }
+            std::cout << std::endl;
+        }
+        std::cout << std::endl;
+    }
+};
@@ -0,0 +1,454 @@
+#pragma once
+
+#include "astar.h"
+
+//Hierarchical path finding (HPA*, Botea, Mueller & Schaeffer 2004) on the navigation grid.
+//The grid is cut into square clusters. Wherever two neighbouring clusters share a run of
+//passable border cells, one or two entrances are placed on it. Entrance cells are the nodes
+//of a small abstract graph: inter edges cross a border in a single step, intra edges connect
+//the nodes of one cluster with the cost of the best path that stays inside the cluster.
+//
+//A query inserts start and goal as temporary nodes, runs A* on the abstract graph and
+//refines only the abstract edges of the result with cluster-bounded A*.
+//Paths are near-optimal, not optimal, because they are forced through the entrances.
+//
+//After add_wall/add_weight call update_region with the changed rectangle: only the clusters
+//touching it and the border data of their neighbours are rebuilt.
+//Diagonal crossings at a corner shared by four clusters are not modelled.
+
+
+struct HpaEdge {
+    int to;
+    float cost;
+    bool inter;                 //crosses a cluster border in one step, needs no refinement
+};
+
+struct HpaNode {
+    int cell = -1;              //grid index, -1 while the node is on the free list
+    int cluster = -1;
+    std::vector<HpaEdge> edges;
+};
+
+//two cells facing each other across a cluster border, a lies in the west/north cluster
+struct HpaEntrance {
+    int a, b;
+    bool diagonal;
+};
+
+struct HpaCluster {
+    GridRect rect;
+    std::vector<int> nodes;
+    std::vector<HpaEntrance> border[2];     //entrances to the east (+x) and south (+y) neighbour
+};
+
+
+struct HpaGraph {
+    int cluster_size = 0;
+    int clusters_x = 0, clusters_y = 0;
+    int width = 0, height = 0;
+    uint32_t version = 0;                   //grid version the graph was built or updated for
+    std::vector<HpaCluster> clusters;
+    std::vector<HpaNode> nodes;
+    std::vector<int> free_nodes;
+    int expanded = 0;                       //abstract nodes + refinement cells of the last query
+
+    bool valid(const NavGrid &grid) const {
+        return version == grid.version && width == grid.width && height == grid.height && !clusters.empty();
+    }
+
+    int cluster_of(const NavGrid &grid, int idx) const {
+        return (grid.y_of(idx) / cluster_size) * clusters_x + grid.x_of(idx) / cluster_size;
+    }
+
+    void build(const NavGrid &grid, int cluster_size_ = 16) {
+        cluster_size = cluster_size_;
+        width = grid.width;
+        height = grid.height;
+        clusters_x = (width + cluster_size - 1) / cluster_size;
+        clusters_y = (height + cluster_size - 1) / cluster_size;
+        clusters.assign(clusters_x * clusters_y, HpaCluster());
+        nodes.clear();
+        free_nodes.clear();
+        for (int cy = 0; cy < clusters_y; cy++) {
+            for (int cx = 0; cx < clusters_x; cx++) {
+                clusters[cy * clusters_x + cx].rect = { cx * cluster_size, cy * cluster_size,
+                                                       std::min((cx + 1) * cluster_size, width) - 1,
+                                                       std::min((cy + 1) * cluster_size, height) - 1 };
+            }
+        }
+        rebuild(grid, { 0, 0, clusters_x - 1, clusters_y - 1 });
+    }
+
+    //the cells in [x0,x1]x[y0,y1] have changed, rebuild the clusters around them
+    void update_region(const NavGrid &grid, int x0, int y0, int x1, int y1) {
+        if (width != grid.width || height != grid.height || clusters.empty()) {
+            build(grid, cluster_size > 0 ? cluster_size : 16);
+            return;
+        }
+        //one cell of margin, a change next to a border alters the entrances on both sides
+        x0 = std::max(x0 - 1, 0); y0 = std::max(y0 - 1, 0);
+        x1 = std::min(x1 + 1, width - 1); y1 = std::min(y1 + 1, height - 1);
+        if (x0 > x1 || y0 > y1) {
+            version = grid.version;
+            return;
+        }
+        rebuild(grid, { x0 / cluster_size, y0 / cluster_size, x1 / cluster_size, y1 / cluster_size });
+    }
+
+    //HPA* query, the refined path is written into ctx like a grid search would do,
+    //so AStarContext::extract_path works on the result
+    SearchStatus find_path(const NavGrid &grid, Cell start, Cell end, AStarContext &ctx) {
+        expanded = 0;
+        if (!grid.if_in_bounds(start) || !grid.passable(end)) return ctx.status = SEARCH_NOT_FOUND;
+        if (!valid(grid)) return a_star(grid, start, end, ctx);
+
+        int s = grid.index(start);
+        int e = grid.index(end);
+        //the landmarks of ctx guide the abstract search and the refinement
+        landmarks = (ctx.landmarks != nullptr && ctx.landmarks->valid(grid)) ? ctx.landmarks : nullptr;
+        local.landmarks = landmarks;
+        int cs = cluster_of(grid, s);
+        int ce = cluster_of(grid, e);
+        cells.clear();
+
+        //short queries inside one cluster do not need the abstract graph
+        if (cs == ce && a_star_begin(grid, start, end, local, &clusters[cs].rect) == SEARCH_IN_PROGRESS &&
+            a_star_run(grid, local) == SEARCH_FOUND) {
+            expanded += local.expanded;
+            append_local_path();
+        } else if (!abstract_path(grid, s, e)) {
+            return ctx.status = SEARCH_NOT_FOUND;
+        }
+        return write_path(grid, s, e, ctx);
+    }
+
+private:
+    AStarContext local;                     //cluster-bounded searches for edges and refinement
+    std::vector<int> cells;                 //refined path of the current query
+    const Landmarks *landmarks = nullptr;   //valid ALT tables of the current query, or nullptr
+
+    //abstract search state, indexed by node
+    std::vector<float> ag;
+    std::vector<int> aparent;
+    std::vector<uint32_t> astamp;
+    uint32_t ageneration = 0;
+    IndexedHeap<float> aopen;
+
+    int new_node(int cell, int cluster) {
+        int n;
+        if (!free_nodes.empty()) {
+            n = free_nodes.back();
+            free_nodes.pop_back();
+        } else {
+            n = (int)nodes.size();
+            nodes.emplace_back();
+        }
+        nodes[n].cell = cell;
+        nodes[n].cluster = cluster;
+        nodes[n].edges.clear();
+        return n;
+    }
+
+    void free_node(int n) {
+        nodes[n].cell = -1;
+        nodes[n].edges.clear();
+        free_nodes.push_back(n);
+    }
+
+    int node_at(int cluster, int cell) const {
+        for (int n : clusters[cluster].nodes) {
+            if (nodes[n].cell == cell) return n;
+        }
+        return -1;
+    }
+
+    int node_or_new(int cluster, int cell) {
+        int n = node_at(cluster, cell);
+        if (n < 0) {
+            n = new_node(cell, cluster);
+            clusters[cluster].nodes.push_back(n);
+        }
+        return n;
+    }
+
+    //entrances on the east (side 0) or south (side 1) border of cluster c
+    void find_entrances(const NavGrid &grid, int c, int side) {
+        HpaCluster &cl = clusters[c];
+        std::vector<HpaEntrance> &out = cl.border[side];
+        out.clear();
+        int cx = c % clusters_x;
+        int cy = c / clusters_x;
+        if ((side == 0 && cx + 1 >= clusters_x) || (side == 1 && cy + 1 >= clusters_y)) return;
+
+        //walk along the border, (ax,ay) is inside c and (ax+ox, ay+oy) inside the neighbour
+        int ox = side == 0 ? 1 : 0;
+        int oy = side == 0 ? 0 : 1;
+        int first = side == 0 ? cl.rect.y0 : cl.rect.x0;
+        int last = side == 0 ? cl.rect.y1 : cl.rect.x1;
+        auto a_of = [&](int k) { return side == 0 ? grid.index(cl.rect.x1, k) : grid.index(k, cl.rect.y1); };
+        auto open = [&](int k) {
+            int a = a_of(k);
+            return !grid.blocked(a) && !grid.blocked(a + oy * grid.width + ox);
+        };
+        int across = oy * grid.width + ox;
+        int along = side == 0 ? grid.width : 1;
+
+        int k = first;
+        while (k <= last) {
+            if (!open(k)) {
+                //only a diagonal step crosses here, keep it so such gaps do not disconnect the graph
+                int a = a_of(k);
+                if (!grid.blocked(a)) {
+                    for (int d = -1; d <= 1; d += 2) {
+                        if (k + d < first || k + d > last || open(k + d)) continue;
+                        if (!grid.blocked(a + across + d * along)) out.push_back({ a, a + across + d * along, true });
+                    }
+                }
+                k++;
+                continue;
+            }
+            int run_start = k;
+            while (k <= last && open(k)) k++;
+            int run_end = k - 1;
+            //short runs get one entrance in the middle, long runs one at each end
+            if (run_end - run_start + 1 < 6) {
+                int a = a_of((run_start + run_end) / 2);
+                out.push_back({ a, a + across, false });
+            } else {
+                out.push_back({ a_of(run_start), a_of(run_start) + across, false });
+                out.push_back({ a_of(run_end), a_of(run_end) + across, false });
+            }
+        }
+    }
+
+    //Dijkstra from source that stays inside rect, reverse gives the costs of the paths towards source
+    void flood_cluster(const NavGrid &grid, int source, const GridRect &rect, bool reverse) {
+        local.begin(grid, source, -1, &rect);
+        local.open.push(source, 0.0f);
+        while (!local.open.empty()) {
+            int current = local.open.pop();
+            float current_cost = local.g[current];
+            grid.for_each_neighbour(current, [&](int next, int dir) {
+                if (!rect.contains(grid.x_of(next), grid.y_of(next))) return;
+                float new_cost = current_cost + grid.step_cost(reverse ? current : next, dir);
+                if (!local.visited(next) || new_cost < local.g[next]) {
+                    local.set(next, new_cost, current);
+                    local.open.push(next, new_cost);
+                }
+            });
+        }
+    }
+
+    void connect_intra(const NavGrid &grid, int c) {
+        const HpaCluster &cl = clusters[c];
+        for (int u : cl.nodes) {
+            flood_cluster(grid, nodes[u].cell, cl.rect, false);
+            for (int v : cl.nodes) {
+                if (v != u && local.visited(nodes[v].cell)) {
+                    nodes[u].edges.push_back({ v, local.g[nodes[v].cell], false });
+                }
+            }
+        }
+    }
+
+    //rebuild clusters in the inclusive cluster rectangle r and the node sets around it
+    void rebuild(const NavGrid &grid, GridRect r) {
+        GridRect around = { std::max(r.x0 - 1, 0), std::max(r.y0 - 1, 0),
+                            std::min(r.x1 + 1, clusters_x - 1), std::min(r.y1 + 1, clusters_y - 1) };
+        auto id = [&](int cx, int cy) { return cy * clusters_x + cx; };
+        //clusters whose nodes are recreated: r plus its 4-neighbours, they share the changed borders
+        auto affected = [&](int cx, int cy) {
+            return r.contains(cx, cy) || ((cx == r.x0 - 1 || cx == r.x1 + 1) && r.y0 <= cy && cy <= r.y1) ||
+                   ((cy == r.y0 - 1 || cy == r.y1 + 1) && r.x0 <= cx && cx <= r.x1);
+        };
+
+        //1. entrances on every border of a dirty cluster
+        for (int cy = around.y0; cy <= r.y1; cy++) {
+            for (int cx = around.x0; cx <= r.x1; cx++) {
+                if (r.contains(cx, cy) || (cx == r.x0 - 1 && cy >= r.y0)) find_entrances(grid, id(cx, cy), 0);
+                if (r.contains(cx, cy) || (cy == r.y0 - 1 && cx >= r.x0)) find_entrances(grid, id(cx, cy), 1);
+            }
+        }
+
+        //2. drop the nodes of affected clusters and the edges into them
+        for (int cy = around.y0; cy <= around.y1; cy++) {
+            for (int cx = around.x0; cx <= around.x1; cx++) {
+                if (!affected(cx, cy)) continue;
+                for (int n : clusters[id(cx, cy)].nodes) free_node(n);
+                clusters[id(cx, cy)].nodes.clear();
+            }
+        }
+        GridRect ring = { std::max(around.x0 - 1, 0), std::max(around.y0 - 1, 0),
+                          std::min(around.x1 + 1, clusters_x - 1), std::min(around.y1 + 1, clusters_y - 1) };
+        for (int cy = ring.y0; cy <= ring.y1; cy++) {
+            for (int cx = ring.x0; cx <= ring.x1; cx++) {
+                if (affected(cx, cy)) continue;
+                for (int n : clusters[id(cx, cy)].nodes) {
+                    auto &edges = nodes[n].edges;
+                    edges.erase(std::remove_if(edges.begin(), edges.end(),
+                                               [&](const HpaEdge &edge) { return nodes[edge.to].cell < 0; }),
+                                edges.end());
+                }
+            }
+        }
+
+        //3. recreate nodes and inter edges on every border with an affected side
+        for (int cy = ring.y0; cy <= around.y1; cy++) {
+            for (int cx = ring.x0; cx <= around.x1; cx++) {
+                for (int side = 0; side < 2; side++) {
+                    int nx = cx + (side == 0);
+                    int ny = cy + (side == 1);
+                    if (nx >= clusters_x || ny >= clusters_y) continue;
+                    if (!affected(cx, cy) && !affected(nx, ny)) continue;
+                    for (const HpaEntrance &en : clusters[id(cx, cy)].border[side]) {
+                        int na = node_or_new(id(cx, cy), en.a);
+                        int nb = node_or_new(id(nx, ny), en.b);
+                        int dir = en.diagonal ? 4 : 0;
+                        nodes[na].edges.push_back({ nb, grid.step_cost(en.b, dir), true });
+                        nodes[nb].edges.push_back({ na, grid.step_cost(en.a, dir), true });
+                    }
+                }
+            }
+        }
+
+        //4. intra edges of the affected clusters
+        for (int cy = around.y0; cy <= around.y1; cy++) {
+            for (int cx = around.x0; cx <= around.x1; cx++) {
+                if (affected(cx, cy)) connect_intra(grid, id(cx, cy));
+            }
+        }
+        version = grid.version;
+    }
+
+    //abstract search from s to e, on success cells holds the refined path
+    bool abstract_path(const NavGrid &grid, int s, int e) {
+        int cs = cluster_of(grid, s);
+        int ce = cluster_of(grid, e);
+
+        //temporary nodes for start and goal, every edge added here is removed again below
+        std::vector<std::pair<int, size_t>> touched;
+        int sn = node_at(cs, s);
+        int en = node_at(ce, e);
+        bool temp_s = sn < 0, temp_e = en < 0;
+        if (temp_s) { sn = new_node(s, cs); clusters[cs].nodes.push_back(sn); }
+        if (temp_e) { en = new_node(e, ce); clusters[ce].nodes.push_back(en); }
+        if (temp_s) {
+            flood_cluster(grid, s, clusters[cs].rect, false);
+            for (int v : clusters[cs].nodes) {
+                if (v != sn && local.visited(nodes[v].cell)) nodes[sn].edges.push_back({ v, local.g[nodes[v].cell], false });
+            }
+        }
+        if (temp_e) {
+            flood_cluster(grid, e, clusters[ce].rect, true);
+            for (int v : clusters[ce].nodes) {
+                if (v != en && local.visited(nodes[v].cell)) {
+                    touched.push_back({ v, nodes[v].edges.size() });
+                    nodes[v].edges.push_back({ en, local.g[nodes[v].cell], false });
+                }
+            }
+        }
+
+        bool found = search_abstract(grid, sn, en);
+        if (found) {
+            std::vector<int> chain;
+            for (int n = en; n != sn; n = aparent[n]) chain.push_back(n);
+            chain.push_back(sn);
+            std::reverse(chain.begin(), chain.end());
+
+            cells.push_back(s);
+            for (size_t i = 0; i + 1 < chain.size() && found; i++) {
+                const HpaNode &u = nodes[chain[i]];
+                const HpaNode &v = nodes[chain[i + 1]];
+                if (u.cluster != v.cluster) {
+                    cells.push_back(v.cell);
+                    continue;
+                }
+                found = a_star_begin(grid, grid.cell(u.cell), grid.cell(v.cell), local, &clusters[u.cluster].rect) == SEARCH_IN_PROGRESS &&
+                        a_star_run(grid, local) == SEARCH_FOUND;
+                expanded += local.expanded;
+                if (found) append_local_path();
+            }
+        }
+
+        for (auto it = touched.rbegin(); it != touched.rend(); ++it) nodes[it->first].edges.resize(it->second);
+        if (temp_e) { clusters[ce].nodes.pop_back(); free_node(en); }
+        if (temp_s) {
+            auto &cn = clusters[cs].nodes;
+            cn.erase(std::find(cn.begin(), cn.end(), sn));
+            free_node(sn);
+        }
+        return found;
+    }
+
+    bool search_abstract(const NavGrid &grid, int sn, int en) {
+        if ((int)ag.size() < (int)nodes.size()) {
+            ag.resize(nodes.size());
+            aparent.resize(nodes.size());
+            astamp.assign(nodes.size(), 0);
+            aopen.resize((int)nodes.size());
+            ageneration = 0;
+        }
+        if (++ageneration == 0) {
+            std::fill(astamp.begin(), astamp.end(), 0);
+            ageneration = 1;
+        }
+        aopen.clear();
+        int goal_cell = nodes[en].cell;
+        //abstract edges are real grid paths, so grid lower bounds stay admissible
+        auto heuristic = [&](int cell) {
+            float h = octile_heuristic(grid, cell, goal_cell);
+            return landmarks != nullptr ? std::max(h, landmarks->lower_bound(cell, goal_cell)) : h;
+        };
+        ag[sn] = 0.0f;
+        aparent[sn] = sn;
+        astamp[sn] = ageneration;
+        aopen.push(sn, heuristic(nodes[sn].cell));
+
+        while (!aopen.empty()) {
+            int current = aopen.pop();
+            if (current == en) return true;
+            expanded++;
+            for (const HpaEdge &edge : nodes[current].edges) {
+                float new_cost = ag[current] + edge.cost;
+                if (astamp[edge.to] != ageneration || new_cost < ag[edge.to]) {
+                    ag[edge.to] = new_cost;
+                    aparent[edge.to] = current;
+                    astamp[edge.to] = ageneration;
+                    aopen.push(edge.to, new_cost + heuristic(nodes[edge.to].cell));
+                }
+            }
+        }
+        return false;
+    }
+
+    //append the path of the last local search, without its first cell if cells already ends there
+    void append_local_path() {
+        size_t from = cells.size();
+        for (int n = local.goal; ; n = local.parent[n]) {
+            cells.push_back(n);
+            if (n == local.start) break;
+        }
+        std::reverse(cells.begin() + from, cells.end());
+        if (from > 0 && cells[from - 1] == cells[from]) cells.erase(cells.begin() + from);
+    }
+
+    //store cells as a parent chain in ctx, loops that the entrances may force are cut out
+    SearchStatus write_path(const NavGrid &grid, int s, int e, AStarContext &ctx) {
+        ctx.begin(grid, s, e);
+        size_t length = 1;
+        for (size_t i = 1; i < cells.size(); i++) {
+            int c = cells[i];
+            if (ctx.visited(c)) {
+                while (cells[length - 1] != c) ctx.stamp[cells[--length]] = ctx.generation - 1;
+                continue;
+            }
+            int p = cells[length - 1];
+            bool diagonal = grid.x_of(c) != grid.x_of(p) && grid.y_of(c) != grid.y_of(p);
+            ctx.set(c, ctx.g[p] + grid.step_cost(c, diagonal ? 4 : 0), p);
+            cells[length++] = c;
+        }
+        cells.resize(length);
+        ctx.expanded = expanded;
+        return ctx.status = ctx.visited(e) ? SEARCH_FOUND : SEARCH_NOT_FOUND;
+    }
+};
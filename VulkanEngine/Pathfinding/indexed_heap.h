@@ -0,0 +1,104 @@
+#pragma once
+
+#include <vector>
+
+//Binary min-heap over node indices [0,n) with decrease-key.
+//Every node is in the heap at most once, pos[] maps a node to its heap slot,
+//so updating a key never pushes a duplicate entry.
+//Key must provide operator<, e.g. float for A* or a (k1,k2) pair for D* Lite.
+template<typename Key = float>
+struct IndexedHeap {
+    struct Entry {
+        Key key;
+        int node;
+    };
+
+    std::vector<Entry> heap;
+    std::vector<int>   pos;     //slot of each node in heap, -1 if not contained
+
+    void resize(int num_nodes) {
+        heap.clear();
+        pos.assign(num_nodes, -1);
+    }
+
+    //empty the heap, touching only the nodes that are still in it
+    void clear() {
+        for (auto &e : heap) pos[e.node] = -1;
+        heap.clear();
+    }
+
+    bool empty() const { return heap.empty(); }
+    int size() const { return (int)heap.size(); }
+    bool contains(int node) const { return pos[node] >= 0; }
+    int top() const { return heap[0].node; }
+    const Key & top_key() const { return heap[0].key; }
+    const Key & key(int node) const { return heap[pos[node]].key; }
+
+    //insert a node or change its key, whatever direction the key moves
+    void push(int node, Key k) {
+        int i = pos[node];
+        if (i < 0) {
+            i = (int)heap.size();
+            heap.push_back({ k, node });
+            pos[node] = i;
+            sift_up(i);
+        } else if (k < heap[i].key) {
+            heap[i].key = k;
+            sift_up(i);
+        } else {
+            heap[i].key = k;
+            sift_down(i);
+        }
+    }
+
+    int pop() {
+        int node = heap[0].node;
+        remove_slot(0);
+        return node;
+    }
+
+    void remove(int node) {
+        if (pos[node] >= 0) remove_slot(pos[node]);
+    }
+
+private:
+    void remove_slot(int i) {
+        pos[heap[i].node] = -1;
+        Entry last = heap.back();
+        heap.pop_back();
+        if (i == (int)heap.size()) return;
+        heap[i] = last;
+        pos[last.node] = i;
+        if (i > 0 && last.key < heap[(i - 1) / 2].key) sift_up(i);
+        else sift_down(i);
+    }
+
+    void sift_up(int i) {
+        Entry e = heap[i];
+        while (i > 0) {
+            int p = (i - 1) / 2;
+            if (!(e.key < heap[p].key)) break;
+            heap[i] = heap[p];
+            pos[heap[i].node] = i;
+            i = p;
+        }
+        heap[i] = e;
+        pos[e.node] = i;
+    }
+
+    void sift_down(int i) {
+        Entry e = heap[i];
+        int n = (int)heap.size();
+        while (true) {
+            int c = 2 * i + 1;
+            if (c >= n) break;
+            if (c + 1 < n && heap[c + 1].key < heap[c].key) c++;
+            if (!(heap[c].key < e.key)) break;
+            heap[i] = heap[c];
+            pos[heap[i].node] = i;
+            i = c;
+        }
+        heap[i] = e;
+        pos[e.node] = i;
+    }
+};
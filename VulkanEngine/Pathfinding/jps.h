@@ -0,0 +1,196 @@
+#pragma once
+
+#include "astar.h"
+
+//Jump Point Search (Harabor & Grastien 2011) on the navigation grid.
+//Diagonal moves may pass wall corners, exactly like the 8-neighbourhood of a_star,
+//so JPS and A* return paths of the same cost.
+//
+//Straight jumps can be answered from a precomputed JumpTable (JPS+), diagonal jumps still walk.
+//
+//JPS is only optimal on uniform costs. A cell is handled by JPS if all cells in its 3x3
+//block have NAV_BASE_COST. Any other cell stops a jump and is expanded into all its
+//neighbours like in weighted A*, so regions touched by add_weight fall back to A*.
+
+
+//true if idx and all its 8 neighbours have the base step cost
+inline bool jps_uniform(const NavGrid &grid, int idx) {
+    return grid.uniform() || !grid.is_weighted_near(idx);
+}
+
+//true if a straight move onto (x,y) in direction (dx,dy) has a forced neighbour
+inline bool jps_forced_straight(const NavGrid &grid, int x, int y, int dx, int dy) {
+    if (dx != 0) {
+        return (!grid.passable(x, y + 1) && grid.passable(x + dx, y + 1)) ||
+               (!grid.passable(x, y - 1) && grid.passable(x + dx, y - 1));
+    }
+    return (!grid.passable(x + 1, y) && grid.passable(x + 1, y + dy)) ||
+           (!grid.passable(x - 1, y) && grid.passable(x - 1, y + dy));
+}
+
+
+//JPS+ style table of precomputed straight jumps, one int16 per cell and straight direction.
+//A value j > 0 means the next jump point is j cells away, j <= 0 means -j free cells and then a wall.
+//The goal is not part of the table, a query checks whether the goal lies on the ray.
+//The table belongs to one grid version and has to be rebuilt after add_wall/add_weight.
+struct JumpTable {
+    std::vector<int16_t> dist[4];       //indexed like NAV_DIR_X/Y 0-3: +y, -y, -x, +x
+    uint32_t version = 0;
+    int width = 0, height = 0;
+
+    bool valid(const NavGrid &grid) const {
+        return version == grid.version && width == grid.width && height == grid.height && !dist[0].empty();
+    }
+
+    void build(const NavGrid &grid) {
+        width = grid.width;
+        height = grid.height;
+        version = grid.version;
+        for (int d = 0; d < 4; d++) dist[d].assign(grid.size(), 0);
+
+        for (int d = 0; d < 4; d++) {
+            int dx = NAV_DIR_X[d];
+            int dy = NAV_DIR_Y[d];
+            int lines = dx != 0 ? height : width;
+            int length = dx != 0 ? width : height;
+            for (int line = 0; line < lines; line++) {
+                //walk each row/column against the direction, so the next cell is already known
+                for (int k = length - 2; k >= 0; k--) {
+                    int along = (dx + dy > 0) ? k : length - 1 - k;
+                    int x = dx != 0 ? along : line;
+                    int y = dx != 0 ? line : along;
+                    int nx = x + dx;
+                    int ny = y + dy;
+                    int n = grid.index(nx, ny);
+                    int16_t &j = dist[d][grid.index(x, y)];
+                    if (grid.blocked(n)) j = 0;
+                    else if (!jps_uniform(grid, n) || jps_forced_straight(grid, nx, ny, dx, dy)) j = 1;
+                    else {
+                        int16_t jn = dist[d][n];
+                        j = jn > 0 ? jn + 1 : jn - 1;
+                    }
+                }
+            }
+        }
+    }
+};
+
+//straight jump using the table, returns the jump point index, the goal if it lies on the ray, or -1
+inline int jps_jump_straight(const NavGrid &grid, const JumpTable &table, int x, int y, int d, int goal) {
+    int j = table.dist[d][grid.index(x, y)];
+    int reach = j > 0 ? j : -j;
+    int gx = grid.x_of(goal) - x;
+    int gy = grid.y_of(goal) - y;
+    int along = NAV_DIR_X[d] != 0 ? gx * NAV_DIR_X[d] : gy * NAV_DIR_Y[d];
+    int across = NAV_DIR_X[d] != 0 ? gy : gx;
+    if (across == 0 && along > 0 && along <= reach) return goal;
+    if (j > 0) return grid.index(x + NAV_DIR_X[d] * j, y + NAV_DIR_Y[d] * j);
+    return -1;
+}
+
+//walk from (x,y) in direction (dx,dy) until a jump point is found
+//returns the index of the jump point or -1 if the walk runs into a wall
+//straight walks are O(1) if a valid jump table is given
+inline int jps_jump(const NavGrid &grid, const JumpTable *table, int x, int y, int dx, int dy, int goal) {
+    if (table != nullptr && (dx == 0 || dy == 0)) {
+        int d = dx != 0 ? (dx > 0 ? 3 : 2) : (dy > 0 ? 0 : 1);
+        return jps_jump_straight(grid, *table, x, y, d, goal);
+    }
+
+    while (true) {
+        x += dx;
+        y += dy;
+        if (!grid.passable(x, y)) return -1;
+
+        int idx = grid.index(x, y);
+        if (idx == goal || !jps_uniform(grid, idx)) return idx;
+
+        if (dx != 0 && dy != 0) {
+            if ((!grid.passable(x - dx, y) && grid.passable(x - dx, y + dy)) ||
+                (!grid.passable(x, y - dy) && grid.passable(x + dx, y - dy))) return idx;
+            if (jps_jump(grid, table, x, y, dx, 0, goal) >= 0 || jps_jump(grid, table, x, y, 0, dy, goal) >= 0) return idx;
+        } else if (jps_forced_straight(grid, x, y, dx, dy)) {
+            return idx;
+        }
+    }
+}
+
+//cost of the straight or diagonal run from a to b, all cells before b have the base cost
+inline float jps_run_cost(const NavGrid &grid, int a, int b) {
+    int dx = std::abs(grid.x_of(b) - grid.x_of(a));
+    int dy = std::abs(grid.y_of(b) - grid.y_of(a));
+    int steps = std::max(dx, dy);
+    int dir = (dx != 0 && dy != 0) ? 4 : 0;
+    float base = dir < 4 ? (float)NAV_BASE_COST : NAV_BASE_COST * NAV_DIAGONAL_FACTOR;
+    return (steps - 1) * base + grid.step_cost(b, dir);
+}
+
+//continue a search started with a_star_begin for at most max_expansions jump points
+//table may be nullptr or stale, then straight jumps scan the grid cell by cell
+inline SearchStatus jps_run(const NavGrid &grid, AStarContext &ctx, const JumpTable *table = nullptr, int max_expansions = INT_MAX) {
+    if (ctx.status != SEARCH_IN_PROGRESS) return ctx.status;
+    if (table != nullptr && !table->valid(grid)) table = nullptr;
+
+    int dirs_x[NAV_NUM_DIRS];
+    int dirs_y[NAV_NUM_DIRS];
+
+    while (!ctx.open.empty()) {
+        if (max_expansions-- <= 0) return ctx.status;
+
+        int current = ctx.open.pop();
+        if (current == ctx.goal) {
+            return ctx.status = SEARCH_FOUND;
+        }
+        ctx.expanded++;
+
+        int x = grid.x_of(current);
+        int y = grid.y_of(current);
+        int p = ctx.parent[current];
+        int num_dirs = 0;
+
+        if (p == current || !jps_uniform(grid, current)) {
+            for (int d = 0; d < NAV_NUM_DIRS; d++) {        //start or weighted region: all neighbours
+                dirs_x[num_dirs] = NAV_DIR_X[d];
+                dirs_y[num_dirs++] = NAV_DIR_Y[d];
+            }
+        } else {                                            //prune by the direction we came from
+            int dx = (x > grid.x_of(p)) - (x < grid.x_of(p));
+            int dy = (y > grid.y_of(p)) - (y < grid.y_of(p));
+            if (dx != 0 && dy != 0) {
+                dirs_x[num_dirs] = dx; dirs_y[num_dirs++] = 0;
+                dirs_x[num_dirs] = 0;  dirs_y[num_dirs++] = dy;
+                dirs_x[num_dirs] = dx; dirs_y[num_dirs++] = dy;
+                if (!grid.passable(x - dx, y)) { dirs_x[num_dirs] = -dx; dirs_y[num_dirs++] = dy; }
+                if (!grid.passable(x, y - dy)) { dirs_x[num_dirs] = dx;  dirs_y[num_dirs++] = -dy; }
+            } else if (dx != 0) {
+                dirs_x[num_dirs] = dx; dirs_y[num_dirs++] = 0;
+                if (!grid.passable(x, y + 1)) { dirs_x[num_dirs] = dx; dirs_y[num_dirs++] = 1; }
+                if (!grid.passable(x, y - 1)) { dirs_x[num_dirs] = dx; dirs_y[num_dirs++] = -1; }
+            } else {
+                dirs_x[num_dirs] = 0; dirs_y[num_dirs++] = dy;
+                if (!grid.passable(x + 1, y)) { dirs_x[num_dirs] = 1;  dirs_y[num_dirs++] = dy; }
+                if (!grid.passable(x - 1, y)) { dirs_x[num_dirs] = -1; dirs_y[num_dirs++] = dy; }
+            }
+        }
+
+        float current_cost = ctx.g[current];
+        for (int i = 0; i < num_dirs; i++) {
+            int next = jps_jump(grid, table, x, y, dirs_x[i], dirs_y[i], ctx.goal);
+            if (next < 0) continue;
+
+            float new_cost = current_cost + jps_run_cost(grid, current, next);
+            if (!ctx.visited(next) || new_cost < ctx.g[next]) {
+                ctx.set(next, new_cost, current);
+                ctx.open.push(next, new_cost + ctx.heuristic(grid, next));
+            }
+        }
+    }
+    return ctx.status = SEARCH_NOT_FOUND;
+}
+
+//Jump Point Search, same interface as a_star
+//the context parents are jump points, AStarContext::extract_path fills in the cells between them
+inline SearchStatus jps(const NavGrid &grid, Cell start, Cell end, AStarContext &ctx, const JumpTable *table = nullptr) {
+    if (a_star_begin(grid, start, end, ctx) != SEARCH_IN_PROGRESS) return ctx.status;
+    return jps_run(grid, ctx, table);
+}
@@ -0,0 +1,163 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "grid.h"
+#include "indexed_heap.h"
+
+//ALT (A*, Landmarks, Triangle inequality) preprocessing.
+//A few landmark cells are picked far apart from each other and one Dijkstra per landmark
+//stores the exact cost between the landmark and every cell. By the triangle inequality
+//d(n, t) >= d(L, t) - d(L, n) and d(n, t) >= d(n, L) - d(t, L), so the largest of these
+//differences is an admissible heuristic. Around walls it is far tighter than the octile
+//distance, which only sees the straight line, and A* expands correspondingly fewer cells.
+//
+//Distances are quantized to uint16 with a scale per landmark and stored interleaved, the
+//K values of one cell are adjacent, so evaluating the heuristic reads one cache line per cell.
+//On a uniform grid the cost is symmetric and only the distances from the landmarks are kept;
+//on a weighted grid a second Dijkstra over the reversed steps gives the distances to them.
+//The tables belong to one grid version, a stale table is ignored by the searches.
+
+
+constexpr uint16_t LANDMARK_UNREACHED = 0xffff;
+
+struct Landmarks {
+    std::vector<int> cells;             //landmark cells
+    std::vector<float> scale;           //cost of one quantization step, per landmark
+    std::vector<uint16_t> from;         //d(L, n) at from[n * count + k]
+    std::vector<uint16_t> to;           //d(n, L), empty on a uniform grid where it equals from
+    int count = 0;
+    uint32_t version = 0;
+    int width = 0, height = 0;
+
+    bool valid(const NavGrid &grid) const {
+        return count > 0 && version == grid.version && width == grid.width && height == grid.height;
+    }
+
+    //pick num_landmarks landmarks by farthest point selection and fill the tables
+    //each landmark is the reachable cell farthest from all landmarks picked before it
+    void build(const NavGrid &grid, int num_landmarks = 8) {
+        version = grid.version;
+        width = grid.width;
+        height = grid.height;
+        count = 0;
+        cells.clear();
+        scale.clear();
+        from.clear();
+        to.clear();
+        int num_cells = grid.size();
+
+        //start next to the center, the first landmark is the cell farthest from there
+        int seed = -1;
+        for (int r = 0; seed < 0 && r <= std::max(width, height); r++) {
+            for (int y = height / 2 - r; seed < 0 && y <= height / 2 + r; y++) {
+                for (int x = width / 2 - r; x <= width / 2 + r; x++) {
+                    if (grid.passable(x, y)) { seed = grid.index(x, y); break; }
+                }
+            }
+        }
+        if (seed < 0 || num_landmarks <= 0) return;
+
+        std::vector<float> dist(num_cells);
+        std::vector<float> nearest(num_cells, INFINITY);  //distance to the closest landmark so far
+        IndexedHeap<float> open;
+        open.resize(num_cells);
+        std::vector<std::vector<float>> forward;
+
+        dijkstra(grid, seed, false, dist, open);
+        int next = farthest(dist);
+        while ((int)cells.size() < num_landmarks && next >= 0) {
+            cells.push_back(next);
+            forward.emplace_back();
+            dijkstra(grid, next, false, forward.back(), open);
+            for (int i = 0; i < num_cells; i++) nearest[i] = std::min(nearest[i], forward.back()[i]);
+            next = farthest(nearest);
+            if (next >= 0 && nearest[next] <= 0.0f) next = -1;     //every reachable cell is a landmark
+        }
+        count = (int)cells.size();
+
+        std::vector<std::vector<float>> backward;
+        if (!grid.uniform()) {
+            for (int k = 0; k < count; k++) {
+                backward.emplace_back();
+                dijkstra(grid, cells[k], true, backward.back(), open);
+            }
+        }
+
+        for (int k = 0; k < count; k++) {
+            float longest = 0.0f;
+            for (int i = 0; i < num_cells; i++) {
+                if (forward[k][i] < INFINITY) longest = std::max(longest, forward[k][i]);
+                if (!backward.empty() && backward[k][i] < INFINITY) longest = std::max(longest, backward[k][i]);
+            }
+            scale.push_back(longest > 0.0f ? longest / (LANDMARK_UNREACHED - 1) : 1.0f);
+        }
+        quantize(forward, from);
+        if (!backward.empty()) quantize(backward, to);
+    }
+
+    //lower bound of the cost from cell n to cell t, 0 if no landmark tells anything
+    float lower_bound(int n, int t) const {
+        const uint16_t *fn = &from[(size_t)n * count];
+        const uint16_t *ft = &from[(size_t)t * count];
+        const uint16_t *tn = to.empty() ? fn : &to[(size_t)n * count];
+        const uint16_t *tt = to.empty() ? ft : &to[(size_t)t * count];
+        float best = 0.0f;
+        for (int k = 0; k < count; k++) {
+            //rounding moves each value by up to half a step, one step off the difference covers both
+            if (fn[k] != LANDMARK_UNREACHED && ft[k] != LANDMARK_UNREACHED) {
+                best = std::max(best, (float)((int)ft[k] - (int)fn[k] - 1) * scale[k]);
+            }
+            if (tn[k] != LANDMARK_UNREACHED && tt[k] != LANDMARK_UNREACHED) {
+                best = std::max(best, (float)((int)tn[k] - (int)tt[k] - 1) * scale[k]);
+            }
+        }
+        return best;
+    }
+
+    size_t memory_bytes() const {
+        return (from.capacity() + to.capacity()) * sizeof(uint16_t) + scale.capacity() * sizeof(float) +
+               cells.capacity() * sizeof(int);
+    }
+
+private:
+    //cost from source to every cell, or with reverse set from every cell to source
+    //a step costs what the cell it enters costs, so the reversed step u <- v is charged at u
+    static void dijkstra(const NavGrid &grid, int source, bool reverse, std::vector<float> &dist, IndexedHeap<float> &open) {
+        dist.assign(grid.size(), INFINITY);
+        open.clear();
+        dist[source] = 0.0f;
+        open.push(source, 0.0f);
+        while (!open.empty()) {
+            int current = open.pop();
+            float current_cost = dist[current];
+            grid.for_each_neighbour(current, [&](int next, int dir) {
+                float new_cost = current_cost + grid.step_cost(reverse ? current : next, dir);
+                if (new_cost < dist[next]) {
+                    dist[next] = new_cost;
+                    open.push(next, new_cost);
+                }
+            });
+        }
+    }
+
+    static int farthest(const std::vector<float> &dist) {
+        int best = -1;
+        for (int i = 0; i < (int)dist.size(); i++) {
+            if (dist[i] < INFINITY && (best < 0 || dist[i] > dist[best])) best = i;
+        }
+        return best;
+    }
+
+    void quantize(const std::vector<std::vector<float>> &dist, std::vector<uint16_t> &table) const {
+        int num_cells = width * height;
+        table.assign((size_t)num_cells * count, LANDMARK_UNREACHED);
+        for (int k = 0; k < count; k++) {
+            for (int i = 0; i < num_cells; i++) {
+                if (dist[k][i] < INFINITY) table[(size_t)i * count + k] = (uint16_t)std::lround(dist[k][i] / scale[k]);
+            }
+        }
+    }
+};
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "nav_bake.h"
+
+//Static geometry of the shipped levels, shared by the game and the pathfinding benchmark.
+//Each block is the unit cube model scaled to size and centered at center (world units, y up).
+//The game loads a model and a Box collider per block, the nav grid is baked from those colliders.
+
+
+struct LevelBlock {
+    const char *name;           //scene node name
+    float center[3];
+    float size[3];
+};
+
+const LevelBlock LEVEL_ONE_WALLS[] = {
+    { "The Cube0", {  75, 10, 100 }, {  10, 20, 100 } },
+    { "The Cube1", { 120, 10,  45 }, { 100, 20,  10 } },
+    { "The Cube3", { 235, 10, 200 }, {  10, 20, 100 } },
+    { "The Cube4", { 190, 10, 245 }, {  80, 20,  10 } },
+    { "The Cube5", { 125, 10, 350 }, {  10, 20, 100 } },
+    { "The Cube6", {  70, 10, 395 }, { 100, 20,  10 } },
+    { "The Cube7", { 255, 10, 350 }, {  10, 20, 100 } },
+    { "The Cube8", { 310, 10, 305 }, { 100, 20,  10 } },
+    { "The Cube9", { 275, 10, 150 }, {  10, 20, 100 } },
+};
+
+const LevelBlock LEVEL_ONE_OUTER_WALLS[] = {
+    { "outerWall1", {  -1, 20, 200 }, {   3, 40, 400 } },
+    { "outerWall2", { 401, 20, 200 }, {   3, 40, 400 } },
+    { "outerWall3", { 200, 20,  -1 }, { 400, 40,   3 } },
+    { "outerWall4", { 200, 20, 401 }, { 400, 40,   3 } },
+};
+
+//platforms the player can jump on, the enemies walk underneath
+const LevelBlock LEVEL_ONE_FLOORS[] = {
+    { "floor1", { 170, 10, 100 }, { 10, 2, 10 } },
+    { "floor2", { 100, 10, 300 }, { 20, 2, 20 } },
+    { "floor3", { 320, 10, 250 }, { 20, 2, 20 } },
+};
+
+inline NavCollider level_block_collider(const LevelBlock &b) {
+    NavCollider c;
+    c.x0 = b.center[0] - 0.5f * b.size[0];  c.x1 = b.center[0] + 0.5f * b.size[0];
+    c.y0 = b.center[1] - 0.5f * b.size[1];  c.y1 = b.center[1] + 0.5f * b.size[1];
+    c.z0 = b.center[2] - 0.5f * b.size[2];  c.z1 = b.center[2] + 0.5f * b.size[2];
+    return c;
+}
+
+//colliders of level one in the order the game creates them
+inline std::vector<NavCollider> level_one_colliders() {
+    std::vector<NavCollider> colliders;
+    for (const LevelBlock &b : LEVEL_ONE_WALLS) colliders.push_back(level_block_collider(b));
+    for (const LevelBlock &b : LEVEL_ONE_OUTER_WALLS) colliders.push_back(level_block_collider(b));
+    for (const LevelBlock &b : LEVEL_ONE_FLOORS) colliders.push_back(level_block_collider(b));
+    return colliders;
+}
@@ -0,0 +1,188 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define NAV_LOS_SSE2 1
+#endif
+
+#include "grid.h"
+
+//Line of sight over the wall bitset of the navigation grid.
+//The line from a to b is traced with Bresenham's algorithm (8-connected, the same moves a path
+//may take). It is visible if no cell strictly between a and b is a wall; the end cells are not
+//tested, so an enemy can see a player standing on top of a wall.
+//The trace always runs from the smaller to the larger cell index, so los(a,b) == los(b,a).
+//
+//line_of_sight_batch tests one target against many observers, four Bresenham walks at a time
+//in SSE2 registers. It gives exactly the same answers as grid_line_of_sight.
+
+
+//walk the Bresenham line from a to b and call stop(idx) for every cell strictly between them
+//returns false as soon as stop returns true, true if the line reaches b
+template<typename F>
+inline bool grid_trace_line(const NavGrid &grid, Cell a, Cell b, F&& stop) {
+    if (!grid.if_in_bounds(a) || !grid.if_in_bounds(b)) return false;
+    if (grid.index(b) < grid.index(a)) std::swap(a, b);
+
+    int dx = std::abs(b.x - a.x), sx = a.x < b.x ? 1 : -1;
+    int dy = std::abs(b.y - a.y), sy = a.y < b.y ? 1 : -1;
+    int err = dx - dy;
+    int idx = grid.index(a);
+    int end = grid.index(b);
+    int step_x = sx;
+    int step_y = sy * grid.width;
+    while (idx != end) {
+        int e2 = 2 * err;
+        if (e2 > -dy) { err -= dy; idx += step_x; }
+        if (e2 < dx)  { err += dx; idx += step_y; }
+        if (idx != end && stop(idx)) return false;
+    }
+    return true;
+}
+
+inline bool grid_line_of_sight(const NavGrid &grid, Cell a, Cell b) {
+    return grid_trace_line(grid, a, b, [&](int idx) { return grid.blocked(idx); });
+}
+
+//true if an agent can walk the straight line from a to b at the cost of the path it replaces:
+//no wall and, unless the whole grid is uniform, no weighted cell in between
+inline bool grid_line_walkable(const NavGrid &grid, Cell a, Cell b) {
+    if (grid.uniform()) return grid_line_of_sight(grid, a, b);
+    return grid_trace_line(grid, a, b, [&](int idx) {
+        return grid.blocked(idx) || grid.cost(idx) != NAV_BASE_COST;
+    });
+}
+
+//visible[i] = grid_line_of_sight(grid, observers[i], target) for i < n
+inline void line_of_sight_batch(const NavGrid &grid, Cell target, const Cell *observers, int n, uint8_t *visible) {
+    int i = 0;
+#ifdef NAV_LOS_SSE2
+    if (grid.if_in_bounds(target)) {
+        int t = grid.index(target);
+        for (; i + 4 <= n; i += 4) {
+            //per lane: current index, end index, |dx|, |dy| and the index steps along x and y
+            alignas(16) int start[4], end[4], adx[4], ady[4], stx[4], sty[4];
+            int live = 0;
+            for (int k = 0; k < 4; k++) {
+                Cell a = observers[i + k];
+                Cell b = target;
+                visible[i + k] = grid.if_in_bounds(a);
+                if (!visible[i + k] || grid.index(a) == t) {
+                    start[k] = end[k] = t;
+                    adx[k] = ady[k] = stx[k] = sty[k] = 0;
+                    continue;
+                }
+                if (t < grid.index(a)) std::swap(a, b);
+                adx[k] = std::abs(b.x - a.x);
+                ady[k] = std::abs(b.y - a.y);
+                stx[k] = a.x < b.x ? 1 : -1;
+                sty[k] = (a.y < b.y ? 1 : -1) * grid.width;
+                start[k] = grid.index(a);
+                end[k] = grid.index(b);
+                live |= 1 << k;
+            }
+
+            __m128i idx = _mm_load_si128((const __m128i *)start);
+            __m128i last = _mm_load_si128((const __m128i *)end);
+            __m128i vdx = _mm_load_si128((const __m128i *)adx);
+            __m128i vdy = _mm_load_si128((const __m128i *)ady);
+            __m128i vsx = _mm_load_si128((const __m128i *)stx);
+            __m128i vsy = _mm_load_si128((const __m128i *)sty);
+            __m128i ndy = _mm_sub_epi32(_mm_setzero_si128(), vdy);
+            __m128i err = _mm_sub_epi32(vdx, vdy);
+
+            while (live) {
+                __m128i e2 = _mm_add_epi32(err, err);
+                __m128i mx = _mm_cmpgt_epi32(e2, ndy);      //step along x
+                __m128i my = _mm_cmplt_epi32(e2, vdx);      //step along y
+                err = _mm_sub_epi32(err, _mm_and_si128(mx, vdy));
+                err = _mm_add_epi32(err, _mm_and_si128(my, vdx));
+                idx = _mm_add_epi32(idx, _mm_and_si128(mx, vsx));
+                idx = _mm_add_epi32(idx, _mm_and_si128(my, vsy));
+                int done = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(idx, last)));
+
+                //finished lanes have zero steps and rest on a valid cell, so all four can be read
+                alignas(16) int cur[4];
+                _mm_store_si128((__m128i *)cur, idx);
+                int hit = (int)grid.blocked(cur[0]) | (int)grid.blocked(cur[1]) << 1 |
+                          (int)grid.blocked(cur[2]) << 2 | (int)grid.blocked(cur[3]) << 3;
+                hit &= live & ~done;
+                int ended = live & (done | hit);
+                if (ended) {
+                    for (int k = 0; k < 4; k++) {
+                        if (hit & (1 << k)) visible[i + k] = 0;
+                    }
+                    live &= ~ended;
+                    __m128i keep = _mm_set_epi32(live & 8 ? -1 : 0, live & 4 ? -1 : 0, live & 2 ? -1 : 0, live & 1 ? -1 : 0);
+                    vsx = _mm_and_si128(vsx, keep);
+                    vsy = _mm_and_si128(vsy, keep);
+                }
+            }
+        }
+    }
+#endif
+    for (; i < n; i++) {
+        visible[i] = grid_line_of_sight(grid, observers[i], target);
+    }
+}
+
+
+//Per-frame cache of line of sight results keyed by the (cell, cell) pair.
+//Open addressing with frame stamps, so begin_frame is O(1) and nothing is ever freed.
+struct LosCache {
+    struct Slot {
+        uint64_t key;
+        uint32_t frame;         //frame the slot was written in, older slots are empty
+        bool visible;
+    };
+
+    std::vector<Slot> slots;
+    uint32_t frame = 1;
+    uint32_t version = 0;       //grid version the current frame's entries were traced on
+    int hits = 0, misses = 0;   //counters of the current frame
+
+    //capacity is rounded up to a power of two
+    LosCache(int capacity = 1024) {
+        int n = 16;
+        while (n < capacity) n *= 2;
+        slots.assign(n, Slot{ 0, 0, false });
+    }
+
+    void begin_frame(const NavGrid &grid) {
+        if (++frame == 0) {
+            for (Slot &s : slots) s.frame = 0;
+            frame = 1;
+        }
+        version = grid.version;
+        hits = misses = 0;
+    }
+
+    bool visible(const NavGrid &grid, Cell a, Cell b) {
+        if (!grid.if_in_bounds(a) || !grid.if_in_bounds(b)) return false;
+        if (version != grid.version) begin_frame(grid);     //walls changed mid frame
+
+        uint32_t ia = grid.index(a), ib = grid.index(b);
+        uint64_t key = ia < ib ? ((uint64_t)ia << 32 | ib) : ((uint64_t)ib << 32 | ia);
+        size_t mask = slots.size() - 1;
+        size_t h = (size_t)((key * 0x9E3779B97F4A7C15ull) >> 32);
+        //a short probe, a full neighbourhood just overwrites its first slot
+        Slot *slot = &slots[h & mask];
+        for (size_t p = 0; p < 4; p++) {
+            Slot &s = slots[(h + p) & mask];
+            if (s.frame == frame && s.key == key) {
+                hits++;
+                return s.visible;
+            }
+            if (s.frame != frame) {
+                slot = &s;
+                break;
+            }
+        }
+        misses++;
+        *slot = Slot{ key, frame, grid_line_of_sight(grid, a, b) };
+        return slot->visible;
+    }
+};
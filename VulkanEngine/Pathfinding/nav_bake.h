@@ -0,0 +1,133 @@
+#pragma once
+
+#include <cstring>
+#include <future>
+
+#include <ThreadPool.h>
+
+#include "grid.h"
+
+//Nav grid baker.
+//Rasterizes the world-space bounds of a level's static colliders into a NavGrid, so the grid
+//follows the scene geometry instead of a second hand-written list of wall rectangles.
+//A collider that reaches into the agent's height range [step_height, agent_height) blocks
+//every cell its footprint touches. A lower one is walkable ground and gives its cells its
+//weight, higher ones (e.g. platforms above the agents) are ignored.
+//The grid is split into tiles that are rasterized in parallel on a ThreadPool.
+//nav_bake_key hashes everything the result depends on, it keys the on-disk cache (nav_cache.h).
+
+
+//axis aligned world bounds of a static collider, y is up
+struct NavCollider {
+    float x0, y0, z0;
+    float x1, y1, z1;
+    float weight = 1.0f;            //step weight of walkable ground
+};
+
+struct NavBakeSettings {
+    int width = 400, height = 400;          //cells along world x and world z
+    float origin_x = 0.0f, origin_z = 0.0f; //world position of the corner of cell (0, 0)
+    float cell_size = 1.0f;
+    float step_height = 0.5f;               //colliders not higher than this can be walked over
+    float agent_height = 8.0f;              //colliders starting above this can be walked under
+    int tile_size = 64;                     //cells per tile side, one tile per job
+};
+
+constexpr uint32_t NAV_BAKE_FORMAT = 1;     //bump when the rasterization rules change
+
+
+//64 bit FNV-1a over the settings and the colliders, in order
+inline uint64_t nav_bake_key(const NavBakeSettings &settings, const std::vector<NavCollider> &colliders) {
+    uint64_t h = 0xcbf29ce484222325ull;
+    auto mix = [&](const void *data, size_t size) {
+        const uint8_t *p = (const uint8_t *)data;
+        for (size_t i = 0; i < size; i++) {
+            h ^= p[i];
+            h *= 0x100000001b3ull;
+        }
+    };
+    auto mix_float = [&](float f) {
+        if (f == 0.0f) f = 0.0f;            //-0 and +0 bake the same grid
+        mix(&f, sizeof(f));
+    };
+    mix(&NAV_BAKE_FORMAT, sizeof(NAV_BAKE_FORMAT));
+    mix(&settings.width, sizeof(settings.width));
+    mix(&settings.height, sizeof(settings.height));
+    mix_float(settings.origin_x);
+    mix_float(settings.origin_z);
+    mix_float(settings.cell_size);
+    mix_float(settings.step_height);
+    mix_float(settings.agent_height);
+    for (const NavCollider &c : colliders) {
+        mix_float(c.x0); mix_float(c.y0); mix_float(c.z0);
+        mix_float(c.x1); mix_float(c.y1); mix_float(c.z1);
+        mix_float(c.weight);
+    }
+    return h;
+}
+
+//bake colliders into grid, which is resized to the settings
+//the tiles run on pool if given, else on the calling thread
+inline void nav_bake(NavGrid &grid, const NavBakeSettings &settings, const std::vector<NavCollider> &colliders,
+                     ThreadPool *pool = nullptr) {
+    const int width = settings.width, height = settings.height;
+
+    //footprint of every collider in cells, a cell counts if its half-open square [x, x+1)
+    //contains a point of the closed footprint
+    struct Footprint {
+        GridRect rect;
+        bool wall;
+        uint8_t cost;
+    };
+    std::vector<Footprint> footprints;
+    footprints.reserve(colliders.size());
+    for (const NavCollider &c : colliders) {
+        if (c.y0 >= settings.agent_height) continue;
+        bool wall = c.y1 > settings.step_height;
+        uint8_t cost = (uint8_t)std::min(std::max(std::round(c.weight * NAV_BASE_COST), 1.0f), 255.0f);
+        if (!wall && cost == NAV_BASE_COST) continue;
+        GridRect r;
+        r.x0 = (int)std::floor((c.x0 - settings.origin_x) / settings.cell_size);
+        r.y0 = (int)std::floor((c.z0 - settings.origin_z) / settings.cell_size);
+        r.x1 = (int)std::floor((c.x1 - settings.origin_x) / settings.cell_size);
+        r.y1 = (int)std::floor((c.z1 - settings.origin_z) / settings.cell_size);
+        if (r.x1 < 0 || r.y1 < 0 || r.x0 >= width || r.y0 >= height) continue;
+        footprints.push_back({ r, wall, cost });
+    }
+
+    //tiles write disjoint cells of byte arrays, the bitset is packed afterwards
+    std::vector<uint8_t> blocked((size_t)width * height, 0);
+    std::vector<uint8_t> costs((size_t)width * height, NAV_BASE_COST);
+    auto bake_tile = [&](GridRect tile) {
+        for (const Footprint &f : footprints) {
+            if (!f.rect.overlaps(tile)) continue;
+            int x0 = std::max(f.rect.x0, tile.x0), x1 = std::min(f.rect.x1, tile.x1);
+            int y0 = std::max(f.rect.y0, tile.y0), y1 = std::min(f.rect.y1, tile.y1);
+            for (int y = y0; y <= y1; y++) {
+                for (int x = x0; x <= x1; x++) {
+                    size_t idx = (size_t)y * width + x;
+                    if (f.wall) blocked[idx] = 1;
+                    else costs[idx] = std::max(costs[idx], f.cost);
+                }
+            }
+        }
+    };
+
+    int tile = std::max(settings.tile_size, 1);
+    std::vector<std::future<void>> jobs;
+    for (int ty = 0; ty < height; ty += tile) {
+        for (int tx = 0; tx < width; tx += tile) {
+            GridRect r{ tx, ty, std::min(tx + tile, width) - 1, std::min(ty + tile, height) - 1 };
+            if (pool != nullptr) jobs.push_back(pool->add(bake_tile, r));
+            else bake_tile(r);
+        }
+    }
+    for (auto &job : jobs) job.get();
+
+    std::vector<uint64_t> walls(((size_t)width * height + 63) / 64, 0);
+    for (size_t i = 0; i < blocked.size(); i++) {
+        walls[i >> 6] |= (uint64_t)blocked[i] << (i & 63);
+    }
+    bool uniform = std::all_of(costs.begin(), costs.end(), [](uint8_t c) { return c == NAV_BASE_COST; });
+    grid.assign(width, height, walls.data(), uniform ? nullptr : costs.data());
+}
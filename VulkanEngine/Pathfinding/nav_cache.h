@@ -0,0 +1,158 @@
+#pragma once
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "grid.h"
+
+//On-disk cache of a baked NavGrid.
+//The file is a fixed header followed by the wall bitset and, only if the grid has weighted
+//cells, one cost byte per cell (a 400x400 level is 20 KB instead of 180 KB).
+//The header stores the key of the geometry the grid was baked from (nav_bake_key); a file
+//with another key, size or format is ignored, so a changed level is simply baked again.
+//Loading memory-maps the file and copies the arrays straight into the grid.
+//The layout is native endian, the cache is meant for the machine that wrote it.
+
+
+struct NavCacheHeader {
+    char     magic[4];          //"NAVG"
+    uint32_t format;
+    uint64_t key;
+    int32_t  width, height;
+    uint32_t flags;
+    uint32_t reserved;
+};
+
+constexpr uint32_t NAV_CACHE_FORMAT = 1;
+constexpr uint32_t NAV_CACHE_COSTS = 1;     //flag: a cost byte per cell follows the walls
+
+
+//read-only memory mapping of a whole file
+class NavMappedFile {
+public:
+    NavMappedFile(const std::string &path) {
+#ifdef _WIN32
+        file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) return;
+        LARGE_INTEGER file_size;
+        if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0) return;
+        mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapping == nullptr) return;
+        void *view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        if (view == nullptr) return;
+        bytes = (const uint8_t *)view;
+        length = (size_t)file_size.QuadPart;
+#else
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return;
+        struct stat st;
+        if (fstat(fd, &st) == 0 && st.st_size > 0) {
+            void *view = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (view != MAP_FAILED) {
+                bytes = (const uint8_t *)view;
+                length = (size_t)st.st_size;
+            }
+        }
+        ::close(fd);            //the mapping stays valid
+#endif
+    }
+
+    ~NavMappedFile() {
+#ifdef _WIN32
+        if (bytes != nullptr) UnmapViewOfFile(bytes);
+        if (mapping != nullptr) CloseHandle(mapping);
+        if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+#else
+        if (bytes != nullptr) munmap((void *)bytes, length);
+#endif
+    }
+
+    NavMappedFile(const NavMappedFile &) = delete;
+    NavMappedFile &operator=(const NavMappedFile &) = delete;
+
+    const uint8_t *data() const { return bytes; }
+    size_t size() const { return length; }
+
+private:
+    const uint8_t *bytes = nullptr;
+    size_t length = 0;
+#ifdef _WIN32
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = nullptr;
+#endif
+};
+
+
+//load the grid cached under key from path, false if there is none or it does not match
+inline bool nav_cache_load(const std::string &path, uint64_t key, NavGrid &grid) {
+    NavMappedFile file(path);
+    if (file.data() == nullptr || file.size() < sizeof(NavCacheHeader)) return false;
+
+    NavCacheHeader header;
+    memcpy(&header, file.data(), sizeof(header));
+    if (memcmp(header.magic, "NAVG", 4) != 0 || header.format != NAV_CACHE_FORMAT || header.key != key) return false;
+    if (header.width <= 0 || header.height <= 0) return false;
+
+    size_t cells = (size_t)header.width * header.height;
+    size_t wall_bytes = (cells + 63) / 64 * sizeof(uint64_t);
+    size_t cost_bytes = (header.flags & NAV_CACHE_COSTS) ? cells : 0;
+    if (file.size() != sizeof(header) + wall_bytes + cost_bytes) return false;
+
+    //the header is 32 bytes and mappings are page aligned, so the bitset is 8 byte aligned
+    const uint64_t *walls = (const uint64_t *)(file.data() + sizeof(header));
+    const uint8_t *costs = cost_bytes > 0 ? file.data() + sizeof(header) + wall_bytes : nullptr;
+    grid.assign(header.width, header.height, walls, costs);
+    return true;
+}
+
+//create the directory the caches are written to, true if it exists afterwards
+inline bool nav_cache_make_dir(const std::string &dir) {
+#ifdef _WIN32
+    return CreateDirectoryA(dir.c_str(), nullptr) != 0 || GetLastError() == ERROR_ALREADY_EXISTS;
+#else
+    struct stat st;
+    return ::mkdir(dir.c_str(), 0755) == 0 || (::stat(dir.c_str(), &st) == 0 && S_ISDIR(st.st_mode));
+#endif
+}
+
+//write grid to path under key, through a temporary file so a reader never sees half a cache
+inline bool nav_cache_write(const std::string &path, uint64_t key, const NavGrid &grid) {
+    NavCacheHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, "NAVG", 4);
+    header.format = NAV_CACHE_FORMAT;
+    header.key = key;
+    header.width = grid.width;
+    header.height = grid.height;
+    header.flags = grid.uniform() ? 0 : NAV_CACHE_COSTS;
+
+    std::string tmp = path + ".tmp";
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        if (!out) return false;
+        out.write((const char *)&header, sizeof(header));
+        out.write((const char *)grid.walls.data(), ((size_t)grid.size() + 63) / 64 * sizeof(uint64_t));
+        if (header.flags & NAV_CACHE_COSTS) out.write((const char *)grid.costs.data(), grid.size());
+        if (!out) {
+            out.close();
+            std::remove(tmp.c_str());
+            return false;
+        }
+    }
+    std::remove(path.c_str());          //rename does not replace an existing file on Windows
+    return std::rename(tmp.c_str(), path.c_str()) == 0;
+}
@@ -0,0 +1,427 @@
+#pragma once
+
+#include <cmath>
+#include <vector>
+
+#include "indexed_heap.h"
+#include "nav_bake.h"
+
+//Navigation mesh built from the static colliders of a level.
+//The walkable area is the baked region minus every blocking collider, with both eroded by the
+//agent radius so that any point of the mesh keeps the agent clear of the walls. The level
+//geometry is axis aligned boxes, so the area is cut into vertical slabs at every collider
+//edge, each slab into its free intervals, and intervals that continue unchanged into the next
+//slab are merged. The result is tens to hundreds of convex polygons (rectangles) instead of a cell
+//per unit of floor, connected by portals, the shared parts of their edges.
+//
+//Queries run A* over the polygons, entering each one where its portal meets the straight line
+//toward the goal, and then pull the path through the corridor of portals with the funnel
+//algorithm. The path is a list of world points on the ground plane (x, z), agents move along
+//it continuously.
+//Cost weights of the grid are not represented, the mesh only knows walkable and blocked.
+
+
+struct NavPoint {
+    float x, z;
+};
+
+inline float nav_distance(NavPoint a, NavPoint b) {
+    return std::sqrt((a.x - b.x) * (a.x - b.x) + (a.z - b.z) * (a.z - b.z));
+}
+
+//twice the signed area of o, a, b, positive if b is left of (counter-clockwise from) o -> a
+inline float nav_cross(NavPoint o, NavPoint a, NavPoint b) {
+    return (a.x - o.x) * (b.z - o.z) - (a.z - o.z) * (b.x - o.x);
+}
+
+//point of portal a-b where the line from -> goal crosses it, clamped to the portal
+inline NavPoint nav_portal_point(NavPoint a, NavPoint b, NavPoint from, NavPoint goal) {
+    float dx = goal.x - from.x, dz = goal.z - from.z;
+    float denom = dx * (b.z - a.z) - dz * (b.x - a.x);
+    float t = 0.5f;
+    if (std::abs(denom) > 1e-6f) t = -(dx * (a.z - from.z) - dz * (a.x - from.x)) / denom;
+    t = std::min(std::max(t, 0.0f), 1.0f);
+    return { a.x + t * (b.x - a.x), a.z + t * (b.z - a.z) };
+}
+
+inline bool operator == (NavPoint a, NavPoint b) {
+    return a.x == b.x && a.z == b.z;
+}
+
+struct NavLink {
+    int to;                     //neighbouring polygon
+    NavPoint a, b;              //portal, the part of the edge shared with it
+};
+
+struct NavPoly {
+    std::vector<NavPoint> verts;    //convex, counter-clockwise
+    std::vector<NavLink> links;
+    NavPoint center;
+    float x0, z0, x1, z1;           //bounds
+};
+
+struct NavMeshSettings {
+    float agent_radius = 2.5f;      //walls and the region border are pushed out by this much
+    float bucket_size = 16.0f;      //side of the lookup buckets of locate()
+};
+
+
+//string pull a path through a corridor of portals (simple stupid funnel algorithm)
+//left[i] and right[i] are the portal ends as seen walking the corridor, the first portal is
+//the start point and the last the goal point, both with left == right
+inline void nav_funnel(const std::vector<NavPoint> &left, const std::vector<NavPoint> &right, std::vector<NavPoint> &path) {
+    path.clear();
+    if (left.empty()) return;
+    NavPoint apex = left[0], funnel_left = left[0], funnel_right = right[0];
+    int apex_index = 0, left_index = 0, right_index = 0;
+    path.push_back(apex);
+
+    for (int i = 1; i < (int)left.size(); i++) {
+        NavPoint l = left[i], r = right[i];
+
+        //narrow the right side, or if it crosses the left side the left corner is a path point
+        if (nav_cross(apex, funnel_right, r) >= 0.0f) {
+            if (apex == funnel_right || nav_cross(apex, funnel_left, r) < 0.0f) {
+                funnel_right = r;
+                right_index = i;
+            } else {
+                apex = funnel_left;
+                apex_index = left_index;
+                path.push_back(apex);
+                funnel_left = funnel_right = apex;
+                left_index = right_index = apex_index;
+                i = apex_index;
+                continue;
+            }
+        }
+
+        //same for the left side
+        if (nav_cross(apex, funnel_left, l) <= 0.0f) {
+            if (apex == funnel_left || nav_cross(apex, funnel_right, l) > 0.0f) {
+                funnel_left = l;
+                left_index = i;
+            } else {
+                apex = funnel_right;
+                apex_index = right_index;
+                path.push_back(apex);
+                funnel_left = funnel_right = apex;
+                left_index = right_index = apex_index;
+                i = apex_index;
+                continue;
+            }
+        }
+    }
+    if (!(path.back() == left.back())) path.push_back(left.back());
+}
+
+
+class NavMesh {
+public:
+    std::vector<NavPoly> polys;
+    int expanded = 0;               //polygons expanded by the last query
+
+    //bake the walkable area of settings' region around colliders, same blocking rules as nav_bake
+    void build(const NavBakeSettings &settings, const std::vector<NavCollider> &colliders,
+               const NavMeshSettings &mesh_settings = NavMeshSettings()) {
+        polys.clear();
+        buckets.clear();
+        float r = mesh_settings.agent_radius;
+        Rect region{ settings.origin_x + r, settings.origin_z + r,
+                     settings.origin_x + settings.width * settings.cell_size - r,
+                     settings.origin_z + settings.height * settings.cell_size - r };
+        if (region.x1 <= region.x0 || region.z1 <= region.z0) return;
+
+        std::vector<Rect> blocked;
+        std::vector<float> xs = { region.x0, region.x1 };
+        for (const NavCollider &c : colliders) {
+            if (c.y0 >= settings.agent_height || c.y1 <= settings.step_height) continue;
+            Rect b{ std::max(c.x0 - r, region.x0), std::max(c.z0 - r, region.z0),
+                    std::min(c.x1 + r, region.x1), std::min(c.z1 + r, region.z1) };
+            if (b.x1 <= b.x0 || b.z1 <= b.z0) continue;
+            blocked.push_back(b);
+            xs.push_back(b.x0);
+            xs.push_back(b.x1);
+        }
+        std::sort(xs.begin(), xs.end());
+        xs.erase(std::unique(xs.begin(), xs.end()), xs.end());
+
+        //free intervals per slab, an interval equal to one of the slab before extends its rectangle
+        std::vector<Rect> rects;
+        std::vector<std::pair<float, float>> cuts, free;
+        for (size_t s = 0; s + 1 < xs.size(); s++) {
+            float sx0 = xs[s], sx1 = xs[s + 1];
+            cuts.clear();
+            for (const Rect &b : blocked) {
+                if (b.x0 < sx1 && b.x1 > sx0) cuts.push_back({ b.z0, b.z1 });
+            }
+            std::sort(cuts.begin(), cuts.end());
+            free.clear();
+            float z = region.z0;
+            for (auto &cut : cuts) {
+                if (cut.first > z) free.push_back({ z, cut.first });
+                z = std::max(z, cut.second);
+            }
+            if (region.z1 > z) free.push_back({ z, region.z1 });
+
+            for (auto &f : free) {
+                bool extended = false;
+                for (Rect &rect : rects) {
+                    if (rect.x1 == sx0 && rect.z0 == f.first && rect.z1 == f.second) {
+                        rect.x1 = sx1;
+                        extended = true;
+                        break;
+                    }
+                }
+                if (!extended) rects.push_back({ sx0, f.first, sx1, f.second });
+            }
+        }
+
+        polys.resize(rects.size());
+        for (size_t i = 0; i < rects.size(); i++) {
+            const Rect &q = rects[i];
+            NavPoly &p = polys[i];
+            p.verts = { { q.x0, q.z0 }, { q.x1, q.z0 }, { q.x1, q.z1 }, { q.x0, q.z1 } };
+            p.center = { 0.5f * (q.x0 + q.x1), 0.5f * (q.z0 + q.z1) };
+            p.x0 = q.x0; p.z0 = q.z0; p.x1 = q.x1; p.z1 = q.z1;
+        }
+        for (size_t i = 0; i < rects.size(); i++) {
+            for (size_t j = i + 1; j < rects.size(); j++) connect((int)i, (int)j, rects[i], rects[j]);
+        }
+        build_buckets(region, mesh_settings.bucket_size);
+    }
+
+    //polygon containing p, -1 if p is off the mesh
+    int locate(NavPoint p) const {
+        if (polys.empty()) return -1;
+        int bx = (int)std::floor((p.x - bucket_x) / bucket_size);
+        int bz = (int)std::floor((p.z - bucket_z) / bucket_size);
+        if (bx < 0 || bz < 0 || bx >= buckets_x || bz >= buckets_z) return -1;
+        for (int i : buckets[bz * buckets_x + bx]) {
+            if (contains(polys[i], p)) return i;
+        }
+        return -1;
+    }
+
+    //polygon containing p, if p is off the mesh it is moved to the closest point of the closest polygon
+    int nearest(NavPoint &p) const {
+        int found = locate(p);
+        if (found >= 0) return found;
+        float best = INFINITY;
+        NavPoint best_point = p;
+        for (int i = 0; i < (int)polys.size(); i++) {
+            NavPoint q = closest_point(polys[i], p);
+            float d = nav_distance(p, q);
+            if (d < best) {
+                best = d;
+                best_point = q;
+                found = i;
+            }
+        }
+        p = best_point;
+        return found;
+    }
+
+    //shortest corridor from start to goal, string pulled into path
+    //start and goal off the mesh are moved onto it first
+    bool find_path(NavPoint start, NavPoint goal, std::vector<NavPoint> &path) {
+        path.clear();
+        expanded = 0;
+        int sp = nearest(start);
+        int gp = nearest(goal);
+        if (sp < 0 || gp < 0) return false;
+        if (sp == gp) {
+            path.push_back(start);
+            path.push_back(goal);
+            return true;
+        }
+
+        if ((int)g.size() != (int)polys.size()) {
+            g.assign(polys.size(), 0.0f);
+            entry.assign(polys.size(), NavPoint{ 0.0f, 0.0f });
+            parent.assign(polys.size(), -1);
+            stamp.assign(polys.size(), 0);
+            open.resize((int)polys.size());
+            generation = 0;
+        }
+        if (++generation == 0) {
+            std::fill(stamp.begin(), stamp.end(), 0);
+            generation = 1;
+        }
+        open.clear();
+        g[sp] = 0.0f;
+        entry[sp] = start;
+        parent[sp] = -1;
+        stamp[sp] = generation;
+        open.push(sp, nav_distance(start, goal));
+
+        bool found = false;
+        while (!open.empty()) {
+            int current = open.pop();
+            if (current == gp) {
+                found = true;
+                break;
+            }
+            expanded++;
+            for (const NavLink &link : polys[current].links) {
+                NavPoint p = nav_portal_point(link.a, link.b, entry[current], goal);
+                float new_cost = g[current] + nav_distance(entry[current], p);
+                if (stamp[link.to] != generation || new_cost < g[link.to]) {
+                    g[link.to] = new_cost;
+                    entry[link.to] = p;
+                    parent[link.to] = current;
+                    stamp[link.to] = generation;
+                    open.push(link.to, new_cost + nav_distance(p, goal));
+                }
+            }
+        }
+        if (!found) return false;
+
+        corridor.clear();
+        for (int p = gp; p >= 0; p = parent[p]) corridor.push_back(p);
+        std::reverse(corridor.begin(), corridor.end());
+
+        portal_left.assign(1, start);
+        portal_right.assign(1, start);
+        for (size_t i = 0; i + 1 < corridor.size(); i++) {
+            const NavPoly &from = polys[corridor[i]];
+            for (const NavLink &link : from.links) {
+                if (link.to != corridor[i + 1]) continue;
+                //seen from inside the polygon we leave, the left end is counter-clockwise
+                NavPoint mid{ 0.5f * (link.a.x + link.b.x), 0.5f * (link.a.z + link.b.z) };
+                bool a_left = nav_cross(from.center, mid, link.a) > 0.0f;
+                portal_left.push_back(a_left ? link.a : link.b);
+                portal_right.push_back(a_left ? link.b : link.a);
+                break;
+            }
+        }
+        portal_left.push_back(goal);
+        portal_right.push_back(goal);
+        nav_funnel(portal_left, portal_right, path);
+        return true;
+    }
+
+    size_t memory_bytes() const {
+        size_t bytes = polys.capacity() * sizeof(NavPoly);
+        for (const NavPoly &p : polys) bytes += p.verts.capacity() * sizeof(NavPoint) + p.links.capacity() * sizeof(NavLink);
+        for (const auto &b : buckets) bytes += b.capacity() * sizeof(int);
+        return bytes + g.capacity() * (sizeof(float) + sizeof(NavPoint) + sizeof(int) + sizeof(uint32_t));
+    }
+
+private:
+    struct Rect {
+        float x0, z0, x1, z1;
+    };
+
+    //link i and j if they share a piece of an edge
+    void connect(int i, int j, const Rect &a, const Rect &b) {
+        float lo, hi;
+        if (a.x1 == b.x0 || b.x1 == a.x0) {
+            lo = std::max(a.z0, b.z0);
+            hi = std::min(a.z1, b.z1);
+            if (hi <= lo) return;
+            float x = a.x1 == b.x0 ? a.x1 : a.x0;
+            polys[i].links.push_back({ j, { x, lo }, { x, hi } });
+            polys[j].links.push_back({ i, { x, lo }, { x, hi } });
+        } else if (a.z1 == b.z0 || b.z1 == a.z0) {
+            lo = std::max(a.x0, b.x0);
+            hi = std::min(a.x1, b.x1);
+            if (hi <= lo) return;
+            float z = a.z1 == b.z0 ? a.z1 : a.z0;
+            polys[i].links.push_back({ j, { lo, z }, { hi, z } });
+            polys[j].links.push_back({ i, { lo, z }, { hi, z } });
+        }
+    }
+
+    void build_buckets(const Rect &region, float size) {
+        bucket_size = std::max(size, 1.0f);
+        bucket_x = region.x0;
+        bucket_z = region.z0;
+        buckets_x = std::max(1, (int)std::ceil((region.x1 - region.x0) / bucket_size));
+        buckets_z = std::max(1, (int)std::ceil((region.z1 - region.z0) / bucket_size));
+        buckets.assign((size_t)buckets_x * buckets_z, std::vector<int>());
+        auto bucket_of = [](float v, float origin, float size, int count) {
+            return std::min(std::max((int)std::floor((v - origin) / size), 0), count - 1);
+        };
+        for (int i = 0; i < (int)polys.size(); i++) {
+            const NavPoly &p = polys[i];
+            int bx0 = bucket_of(p.x0, bucket_x, bucket_size, buckets_x), bx1 = bucket_of(p.x1, bucket_x, bucket_size, buckets_x);
+            int bz0 = bucket_of(p.z0, bucket_z, bucket_size, buckets_z), bz1 = bucket_of(p.z1, bucket_z, bucket_size, buckets_z);
+            for (int bz = bz0; bz <= bz1; bz++) {
+                for (int bx = bx0; bx <= bx1; bx++) buckets[bz * buckets_x + bx].push_back(i);
+            }
+        }
+    }
+
+    static bool contains(const NavPoly &poly, NavPoint p) {
+        if (p.x < poly.x0 || p.x > poly.x1 || p.z < poly.z0 || p.z > poly.z1) return false;
+        for (size_t i = 0; i < poly.verts.size(); i++) {
+            if (nav_cross(poly.verts[i], poly.verts[(i + 1) % poly.verts.size()], p) < 0.0f) return false;
+        }
+        return true;
+    }
+
+    static NavPoint closest_point(const NavPoly &poly, NavPoint p) {
+        if (contains(poly, p)) return p;
+        NavPoint best = poly.verts[0];
+        float best_distance = INFINITY;
+        for (size_t i = 0; i < poly.verts.size(); i++) {
+            NavPoint a = poly.verts[i], b = poly.verts[(i + 1) % poly.verts.size()];
+            float ex = b.x - a.x, ez = b.z - a.z;
+            float length2 = ex * ex + ez * ez;
+            float t = length2 > 0.0f ? ((p.x - a.x) * ex + (p.z - a.z) * ez) / length2 : 0.0f;
+            t = std::min(std::max(t, 0.0f), 1.0f);
+            NavPoint q{ a.x + t * ex, a.z + t * ez };
+            float d = nav_distance(p, q);
+            if (d < best_distance) {
+                best_distance = d;
+                best = q;
+            }
+        }
+        return best;
+    }
+
+    //lookup grid of locate(), every bucket lists the polygons overlapping it
+    std::vector<std::vector<int>> buckets;
+    float bucket_x = 0.0f, bucket_z = 0.0f, bucket_size = 16.0f;
+    int buckets_x = 0, buckets_z = 0;
+
+    //search state, indexed by polygon
+    std::vector<float> g;
+    std::vector<NavPoint> entry;            //where the best known path enters the polygon
+    std::vector<int> parent;
+    std::vector<uint32_t> stamp;
+    uint32_t generation = 0;
+    IndexedHeap<float> open;
+    std::vector<int> corridor;
+    std::vector<NavPoint> portal_left, portal_right;
+};
+
+
+//walks an agent along a navmesh path
+struct NavMeshFollower {
+    std::vector<NavPoint> points;
+    size_t cursor = 0;
+
+    //replace the path, the first point is where the agent stands
+    void set(const std::vector<NavPoint> &path) {
+        points = path;
+        cursor = points.size() > 1 ? 1 : points.size();
+    }
+
+    void clear() {
+        points.clear();
+        cursor = 0;
+    }
+
+    bool done() const { return cursor >= points.size(); }
+
+    NavPoint goal() const { return points.back(); }
+
+    //the point to head for from current, points closer than arrive count as reached
+    bool next(NavPoint current, float arrive, NavPoint &target) {
+        while (!done() && nav_distance(points[cursor], current) <= arrive) cursor++;
+        if (done()) return false;
+        target = points[cursor];
+        return true;
+    }
+};
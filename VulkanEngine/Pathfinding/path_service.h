@@ -0,0 +1,210 @@
+#pragma once
+
+#include <algorithm>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+#include <ThreadPool.h>
+
+#include "pathfinding.h"
+
+//Asynchronous path requests.
+//Callers submit (start, goal) and get a ticket back. The searches run on the workers of a
+//ThreadPool against an immutable snapshot of the grid, so the game may keep changing its
+//grid meanwhile. Finished searches are handed over in deliver(), which the game calls at the
+//start of a frame, so a result is never visible in the frame it was computed in.
+//Requests for the same (start, goal) on the same snapshot share one search and one ticket.
+//
+//The pool is FIFO and shared with the engine, which waits on its own jobs every frame, so a burst
+//of searches queued ahead of them would stall the frame. At most max_searches searches are on
+//the pool at once, by default one less than its threads, so one thread is always left for the
+//engine. Further requests wait in the service; a worker that finishes a search takes the next
+//waiting one itself, so searches never queue in the pool.
+//
+//Everything except the search itself runs on the calling (main) thread.
+//PATH_HPA runs as PATH_ASTAR here, an HpaGraph is modified by its queries and cannot be shared.
+
+
+typedef uint32_t PathTicket;
+constexpr PathTicket PATH_NO_TICKET = 0;
+
+class PathService {
+public:
+    PathService(ThreadPool *pool_ = nullptr, PathMode mode_ = PATH_JPS)
+        : pool(pool_), mode(mode_), shared(std::make_shared<Shared>()) {}
+
+    void set_thread_pool(ThreadPool *pool_) { pool = pool_; }
+    void set_mode(PathMode mode_) { mode = mode_; }
+    //0 for one less than the threads of the pool, never more than that or less than one
+    void set_max_searches(int max_searches_) { max_searches = max_searches_; }
+
+    //take a new snapshot if the grid changed since the last one, cheap otherwise
+    //table and landmarks are copied along if they are valid for the grid
+    void set_grid(const NavGrid &grid, const JumpTable *table = nullptr, const Landmarks *landmarks = nullptr) {
+        if (grid_snapshot != nullptr && grid_snapshot->version == grid.version && grid_snapshot->size() == grid.size()) return;
+        grid_snapshot = std::make_shared<const NavGrid>(grid);
+        table_snapshot = (table != nullptr && table->valid(grid)) ? std::make_shared<const JumpTable>(*table) : nullptr;
+        landmarks_snapshot = (landmarks != nullptr && landmarks->valid(grid)) ? std::make_shared<const Landmarks>(*landmarks) : nullptr;
+        inflight.clear();         //new requests must not join searches on the old snapshot
+    }
+
+    //submit a search, returns PATH_NO_TICKET if no grid has been set
+    PathTicket request(Cell start, Cell goal) {
+        if (grid_snapshot == nullptr) return PATH_NO_TICKET;
+        uint64_t key = ((uint64_t)(uint32_t)grid_snapshot->index(start) << 32) | (uint32_t)grid_snapshot->index(goal);
+        if (!grid_snapshot->if_in_bounds(start) || !grid_snapshot->if_in_bounds(goal)) key = ~(uint64_t)0;
+
+        auto it = inflight.find(key);
+        if (it != inflight.end()) {
+            tickets[it->second].refs++;
+            num_coalesced++;
+            return it->second;
+        }
+
+        PathTicket ticket = ++next_ticket == PATH_NO_TICKET ? ++next_ticket : next_ticket;
+        tickets[ticket].key = key;
+        inflight[key] = ticket;
+
+        std::shared_ptr<Shared> out = shared;
+        std::shared_ptr<const NavGrid> grid = grid_snapshot;
+        std::shared_ptr<const JumpTable> table = table_snapshot;
+        std::shared_ptr<const Landmarks> landmarks = landmarks_snapshot;
+        PathMode search_mode = mode;
+        auto job = [out, grid, table, landmarks, search_mode, ticket, start, goal]() {
+            thread_local AStarContext ctx;          //one search context per worker thread
+            ctx.landmarks = landmarks.get();
+            Result result;
+            result.ticket = ticket;
+            result.status = find_path(*grid, start, goal, ctx, search_mode, table.get());
+            ctx.extract_path(*grid, result.path);
+            std::lock_guard<std::mutex> lock(out->mutex);
+            out->done.push_back(std::move(result));
+        };
+        if (pool == nullptr) {
+            job();
+            return ticket;
+        }
+
+        bool start_now;
+        {
+            std::lock_guard<std::mutex> lock(out->mutex);
+            start_now = out->running < search_limit();
+            if (start_now) out->running++;
+            else out->waiting.push_back(job);
+        }
+        if (start_now) pool->add([out, job]() { drain(out, job); });
+        return ticket;
+    }
+
+    //hand finished searches over to their tickets, call once at the start of a frame
+    void deliver() {
+        {
+            std::lock_guard<std::mutex> lock(shared->mutex);
+            delivering.swap(shared->done);
+        }
+        for (Result &result : delivering) {
+            auto it = tickets.find(result.ticket);
+            if (it == tickets.end()) continue;     //every requester cancelled
+            it->second.ready = true;
+            it->second.status = result.status;
+            it->second.path = std::move(result.path);
+            finish(it->second.key, result.ticket);
+        }
+        delivering.clear();
+    }
+
+    bool ready(PathTicket ticket) const {
+        auto it = tickets.find(ticket);
+        return it != tickets.end() && it->second.ready;
+    }
+
+    //if the result of ticket has been delivered, copy it out and release the ticket for this requester
+    bool collect(PathTicket ticket, std::vector<Cell> &path, SearchStatus &status) {
+        auto it = tickets.find(ticket);
+        if (it == tickets.end() || !it->second.ready) return false;
+        status = it->second.status;
+        path = it->second.path;
+        release(it);
+        return true;
+    }
+
+    //the requester is no longer interested, the search still runs but its result is dropped
+    void cancel(PathTicket ticket) {
+        auto it = tickets.find(ticket);
+        if (it != tickets.end()) release(it);
+    }
+
+    int pending() const { return (int)inflight.size(); }
+    int coalesced() const { return num_coalesced; }
+
+private:
+    struct Result {
+        PathTicket ticket;
+        SearchStatus status;
+        std::vector<Cell> path;
+    };
+
+    struct Ticket {
+        uint64_t key = 0;           //(start, goal) the search was coalesced under
+        int refs = 1;               //requesters that have not collected or cancelled yet
+        bool ready = false;
+        SearchStatus status = SEARCH_IN_PROGRESS;
+        std::vector<Cell> path;
+    };
+
+    //state the worker jobs write to, outlives the service while jobs are queued
+    struct Shared {
+        std::mutex mutex;
+        std::vector<Result> done;
+        std::deque<std::function<void()>> waiting;     //searches over the limit, run by the next worker that is done
+        int running = 0;                                //searches on the pool
+    };
+
+    //runs on a worker: job, then the waiting searches until there are none left
+    static void drain(std::shared_ptr<Shared> out, std::function<void()> job) {
+        while (job) {
+            job();
+            std::lock_guard<std::mutex> lock(out->mutex);
+            if (out->waiting.empty()) {
+                out->running--;
+                job = nullptr;
+            } else {
+                job = std::move(out->waiting.front());
+                out->waiting.pop_front();
+            }
+        }
+    }
+
+    int search_limit() const {
+        int threads = std::max((int)pool->threadCount() - 1, 1);
+        return max_searches > 0 ? std::min(max_searches, threads) : threads;
+    }
+
+    //new requests for key no longer join ticket, unless a newer snapshot already replaced it
+    void finish(uint64_t key, PathTicket ticket) {
+        auto f = inflight.find(key);
+        if (f != inflight.end() && f->second == ticket) inflight.erase(f);
+    }
+
+    void release(std::unordered_map<PathTicket, Ticket>::iterator it) {
+        if (--it->second.refs > 0) return;
+        if (!it->second.ready) finish(it->second.key, it->first);
+        tickets.erase(it);
+    }
+
+    ThreadPool *pool;
+    PathMode mode;
+    int max_searches = 0;
+    std::shared_ptr<Shared> shared;
+    std::shared_ptr<const NavGrid> grid_snapshot;
+    std::shared_ptr<const JumpTable> table_snapshot;
+    std::shared_ptr<const Landmarks> landmarks_snapshot;
+    std::unordered_map<uint64_t, PathTicket> inflight;       //(start, goal) -> ticket of the running search
+    std::unordered_map<PathTicket, Ticket> tickets;
+    std::vector<Result> delivering;
+    PathTicket next_ticket = PATH_NO_TICKET;
+    int num_coalesced = 0;
+};
@@ -0,0 +1,96 @@
+#pragma once
+
+#include "line_of_sight.h"
+
+//Path post-processing.
+//A searched path holds one Cell (16 bytes) per step. compress_path keeps only the cells where
+//the direction changes, as 4 byte waypoints. string_pull then drops every waypoint that the
+//agent can skip by walking a straight line (grid_line_walkable) to a later one.
+//PathFollower walks the result with a cursor, so following costs O(1) per frame.
+
+
+struct Waypoint {
+    int16_t x, y;
+};
+
+inline bool operator == (Waypoint a, Cell b) {
+    return a.x == b.x && a.y == b.y;
+}
+
+inline Cell waypoint_cell(Waypoint w) {
+    return Cell(w.x, w.y);
+}
+
+//keep the first and last cell and every cell where the step direction changes
+inline void compress_path(const std::vector<Cell> &path, std::vector<Waypoint> &out) {
+    out.clear();
+    if (path.empty()) return;
+    out.push_back({ (int16_t)path[0].x, (int16_t)path[0].y });
+    for (size_t i = 1; i + 1 < path.size(); i++) {
+        int dx0 = path[i].x - path[i - 1].x, dy0 = path[i].y - path[i - 1].y;
+        int dx1 = path[i + 1].x - path[i].x, dy1 = path[i + 1].y - path[i].y;
+        if (dx0 != dx1 || dy0 != dy1) out.push_back({ (int16_t)path[i].x, (int16_t)path[i].y });
+    }
+    if (path.size() > 1) out.push_back({ (int16_t)path.back().x, (int16_t)path.back().y });
+}
+
+//greedy string pulling: from each kept waypoint jump to the furthest one still walkable in a straight line
+inline void string_pull(const NavGrid &grid, std::vector<Waypoint> &points) {
+    if (points.size() < 3) return;
+    size_t kept = 0;
+    size_t i = 0;
+    while (i + 1 < points.size()) {
+        size_t next = i + 1;
+        while (next + 1 < points.size() &&
+               grid_line_walkable(grid, waypoint_cell(points[i]), waypoint_cell(points[next + 1]))) {
+            next++;
+        }
+        points[kept++] = points[i];
+        i = next;
+    }
+    points[kept++] = points.back();
+    points.resize(kept);
+}
+
+
+//Follows a waypoint path. The cursor points at the waypoint the agent is heading for
+//and only moves forward, so each call is O(1).
+struct PathFollower {
+    std::vector<Waypoint> points;
+    size_t cursor = 0;
+
+    //replace the path, the first cell is where the agent stands
+    void set(const NavGrid &grid, const std::vector<Cell> &path, bool smooth = true) {
+        compress_path(path, points);
+        if (smooth) string_pull(grid, points);
+        cursor = points.size() > 1 ? 1 : points.size();
+    }
+
+    void clear() {
+        points.clear();
+        cursor = 0;
+    }
+
+    bool done() const { return cursor >= points.size(); }
+
+    //the waypoint to head for from the agent at (x, y), false once the last one has been reached
+    //waypoints whose cell centre is closer than arrive, or that the agent has passed, count as reached
+    bool next(float x, float y, float arrive, Cell &target) {
+        while (!done() && reached(x, y, arrive)) cursor++;
+        if (done()) return false;
+        target = waypoint_cell(points[cursor]);
+        return true;
+    }
+
+private:
+    //a step longer than a cell jumps over the waypoint, so passing it along the segment
+    //from the previous waypoint counts as well
+    bool reached(float x, float y, float arrive) const {
+        float cx = points[cursor].x + 0.5f, cy = points[cursor].y + 0.5f;
+        float dx = x - cx, dy = y - cy;
+        if (dx * dx + dy * dy <= arrive * arrive) return true;
+        if (cursor == 0) return false;
+        float sx = cx - (points[cursor - 1].x + 0.5f), sy = cy - (points[cursor - 1].y + 0.5f);
+        return dx * sx + dy * sy >= 0.0f;
+    }
+};
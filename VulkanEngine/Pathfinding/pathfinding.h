@@ -0,0 +1,49 @@
+#pragma once
+
+//Umbrella header of the grid pathfinding module, pulls in every search mode
+
+#include "grid.h"
+#include "landmarks.h"
+#include "astar.h"
+#include "jps.h"
+#include "hpa.h"
+#include "flow_field.h"
+#include "dstar_lite.h"
+#include "line_of_sight.h"
+#include "path_smoothing.h"
+
+
+enum PathMode {
+    PATH_ASTAR,     //weighted A* over all 8 neighbours
+    PATH_JPS,       //Jump Point Search, A* expansion only in weighted regions
+    PATH_HPA        //HPA* over cluster entrances, near-optimal, for long queries
+};
+
+//table is optional and only used by PATH_JPS
+//hpa is only used by PATH_HPA, without it or if it is stale the query runs as PATH_ASTAR
+inline SearchStatus find_path(const NavGrid &grid, Cell start, Cell end, AStarContext &ctx, PathMode mode,
+                              const JumpTable *table = nullptr, HpaGraph *hpa = nullptr) {
+    switch (mode) {
+        case PATH_HPA:
+            if (hpa != nullptr) return hpa->find_path(grid, start, end, ctx);
+            return a_star(grid, start, end, ctx);
+        case PATH_JPS:
+            return jps(grid, start, end, ctx, table);
+        case PATH_ASTAR:
+        default:
+            return a_star(grid, start, end, ctx);
+    }
+}
+
+//continue a sliced search of the given mode
+//HPA* queries are answered in one call, a sliced PATH_HPA search continues as PATH_ASTAR
+inline SearchStatus find_path_run(const NavGrid &grid, AStarContext &ctx, PathMode mode,
+                                  int max_expansions = INT_MAX, const JumpTable *table = nullptr) {
+    switch (mode) {
+        case PATH_JPS:
+            return jps_run(grid, ctx, table, max_expansions);
+        case PATH_ASTAR:
+        default:
+            return a_star_run(grid, ctx, max_expansions);
+    }
+}
@@ -0,0 +1,252 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <future>
+#include <map>
+#include <vector>
+
+#include <ThreadPool.h>
+
+#include "grid.h"
+#include "line_of_sight.h"
+#include "nav_cache.h"
+
+//Potentially visible set between square regions of the nav grid.
+//The grid is cut into region_size x region_size regions. Two regions are potentially visible
+//to each other if a line of sight (line_of_sight.h) connects a passable cell on the border of
+//one with a passable cell on the border of the other. Every border cell is traced, skipping some
+//misses lines through openings narrower than the gap. Lines of sight are symmetric, so only the
+//pairs a < b are traced.
+//A line between cells of the two regions leaves the one and enters the other through their
+//borders, but that is not a proof: the Bresenham line between the two border cells it crosses is
+//not the same cells as that stretch of the longer line, so a wall can block the one and not the
+//other. "Hidden" only means no border cell of the one region sees a border cell of the other.
+//pathfinding_bench checks the hidden pairs of level one against grid_line_of_sight.
+//
+//The result is a bitset matrix, one row of region bits per region, identical rows are stored
+//once. Building traces up to samples^2 lines per hidden pair, about 17 seconds on one core for
+//level one, so the rows run on a ThreadPool if given, the build can be cancelled from another
+//thread, and the game caches the set on disk next to the nav grid (pvs_cache_load / pvs_cache_write).
+//The set belongs to one grid version; a stale, cancelled or not yet built set answers
+//"potentially visible" for everything.
+
+
+class PotentiallyVisibleSet {
+public:
+    int region_size = 32;
+    int regions_x = 0, regions_y = 0;
+    int words = 0;                  //uint64 per row
+    std::vector<uint64_t> rows;     //distinct rows, words each
+    std::vector<uint16_t> row_of;   //row of every region
+    uint32_t version = 0;
+    int width = 0, height = 0;
+
+    bool valid(const NavGrid &grid) const {
+        return version == grid.version && width == grid.width && height == grid.height && !row_of.empty();
+    }
+
+    int num_regions() const { return regions_x * regions_y; }
+
+    int region_of(Cell c) const {
+        return c.y / region_size * regions_x + c.x / region_size;
+    }
+
+    //rows run on pool if given, else on the calling thread
+    //once cancel is set the build stops and leaves an empty set
+    void build(const NavGrid &grid, int region_size_ = 32, ThreadPool *pool = nullptr, const std::atomic<bool> *cancel = nullptr) {
+        resize(grid, region_size_);
+        int n = num_regions();
+
+        std::vector<std::vector<Cell>> samples(n);
+        for (int r = 0; r < n; r++) border_samples(grid, r, samples[r]);
+
+        //row a holds the pairs a < b, mirrored below, so the jobs never write the same row
+        std::vector<uint64_t> matrix((size_t)n * words, 0);
+        auto build_row = [&](int a) {
+            if (cancel != nullptr && *cancel) return;
+            uint64_t *row = &matrix[(size_t)a * words];
+            const std::vector<Cell> &from = samples[a];
+            std::vector<uint8_t> visible(from.size());
+            for (int b = a + 1; b < n && !from.empty(); b++) {
+                bool seen = false;
+                for (size_t t = 0; t < samples[b].size() && !seen; t++) {
+                    line_of_sight_batch(grid, samples[b][t], from.data(), (int)from.size(), visible.data());
+                    for (uint8_t v : visible) seen |= v != 0;
+                }
+                if (seen) row[b >> 6] |= (uint64_t)1 << (b & 63);
+            }
+        };
+        std::vector<std::future<void>> jobs;
+        for (int a = 0; a < n; a++) {
+            if (pool != nullptr) jobs.push_back(pool->add(build_row, a));
+            else build_row(a);
+        }
+        for (auto &job : jobs) job.get();
+        if (cancel != nullptr && *cancel) {
+            resize(grid, region_size);
+            return;
+        }
+
+        for (int a = 0; a < n; a++) {
+            matrix[(size_t)a * words + (a >> 6)] |= (uint64_t)1 << (a & 63);
+            for (int b = a + 1; b < n; b++) {
+                if ((matrix[(size_t)a * words + (b >> 6)] >> (b & 63)) & 1) {
+                    matrix[(size_t)b * words + (a >> 6)] |= (uint64_t)1 << (a & 63);
+                }
+            }
+        }
+        compress(matrix);
+    }
+
+    //set up the region layout for grid without any rows, e.g. before loading them
+    void resize(const NavGrid &grid, int region_size_) {
+        region_size = std::max(region_size_, 1);
+        version = grid.version;
+        width = grid.width;
+        height = grid.height;
+        regions_x = (width + region_size - 1) / region_size;
+        regions_y = (height + region_size - 1) / region_size;
+        words = (num_regions() + 63) / 64;
+        rows.clear();
+        row_of.clear();
+    }
+
+    //store every distinct row of the full matrix once
+    void compress(const std::vector<uint64_t> &matrix) {
+        int n = num_regions();
+        std::map<std::vector<uint64_t>, int> distinct;
+        rows.clear();
+        row_of.assign(n, 0);
+        for (int a = 0; a < n; a++) {
+            std::vector<uint64_t> row(matrix.begin() + (size_t)a * words, matrix.begin() + (size_t)(a + 1) * words);
+            auto it = distinct.find(row);
+            if (it == distinct.end()) {
+                it = distinct.emplace(row, (int)distinct.size()).first;
+                rows.insert(rows.end(), row.begin(), row.end());
+            }
+            row_of[a] = (uint16_t)it->second;
+        }
+    }
+
+    bool is_potentially_visible(int a, int b) const {
+        if (row_of.empty() || a < 0 || b < 0 || a >= num_regions() || b >= num_regions()) return true;
+        const uint64_t *row = &rows[(size_t)row_of[a] * words];
+        return (row[b >> 6] >> (b & 63)) & 1;
+    }
+
+    //false if no border cell of the region of a sees a border cell of the region of b
+    bool is_potentially_visible(const NavGrid &grid, Cell a, Cell b) const {
+        if (!valid(grid) || !grid.if_in_bounds(a) || !grid.if_in_bounds(b)) return true;
+        return is_potentially_visible(region_of(a), region_of(b));
+    }
+
+    //regions potentially visible from region, including itself
+    void visible_regions(int region, std::vector<int> &out) const {
+        out.clear();
+        if (row_of.empty() || region < 0 || region >= num_regions()) return;
+        const uint64_t *row = &rows[(size_t)row_of[region] * words];
+        for (int w = 0; w < words; w++) {
+            for (uint64_t bits = row[w]; bits != 0; bits &= bits - 1) {
+                int bit = 0;
+                while (!((bits >> bit) & 1)) bit++;
+                out.push_back(w * 64 + bit);
+            }
+        }
+    }
+
+    int num_rows() const { return words > 0 ? (int)(rows.size() / words) : 0; }
+
+    size_t memory_bytes() const {
+        return rows.capacity() * sizeof(uint64_t) + row_of.capacity() * sizeof(uint16_t);
+    }
+
+private:
+    //every passable cell of the border ring of region r
+    void border_samples(const NavGrid &grid, int r, std::vector<Cell> &samples) const {
+        int x0 = r % regions_x * region_size, y0 = r / regions_x * region_size;
+        int x1 = std::min(x0 + region_size, width) - 1, y1 = std::min(y0 + region_size, height) - 1;
+        auto add = [&](int x, int y) {
+            if (grid.passable(x, y)) samples.push_back(Cell(x, y));
+        };
+        for (int x = x0; x <= x1; x++) {
+            add(x, y0);
+            if (y1 != y0) add(x, y1);
+        }
+        for (int y = y0 + 1; y < y1; y++) {
+            add(x0, y);
+            if (x1 != x0) add(x1, y);
+        }
+    }
+
+};
+
+
+//On-disk cache of a PotentiallyVisibleSet, laid out like the nav grid cache (nav_cache.h):
+//a fixed header, the row index of every region and the distinct rows.
+struct PvsCacheHeader {
+    char     magic[4];          //"NPVS"
+    uint32_t format;
+    uint64_t key;
+    int32_t  region_size, regions_x, regions_y;
+    int32_t  num_rows;
+};
+
+constexpr uint32_t PVS_CACHE_FORMAT = 2;     //2: every border cell is sampled, sets of format 1 may miss sight lines
+
+//load the set cached under key for grid, false if there is none or it does not match
+inline bool pvs_cache_load(const std::string &path, uint64_t key, const NavGrid &grid, PotentiallyVisibleSet &pvs) {
+    NavMappedFile file(path);
+    if (file.data() == nullptr || file.size() < sizeof(PvsCacheHeader)) return false;
+
+    PvsCacheHeader header;
+    memcpy(&header, file.data(), sizeof(header));
+    if (memcmp(header.magic, "NPVS", 4) != 0 || header.format != PVS_CACHE_FORMAT || header.key != key) return false;
+    if (header.region_size <= 0 || header.num_rows <= 0) return false;
+
+    PotentiallyVisibleSet loaded;
+    loaded.resize(grid, header.region_size);
+    if (loaded.regions_x != header.regions_x || loaded.regions_y != header.regions_y) return false;
+    size_t index_bytes = (size_t)loaded.num_regions() * sizeof(uint16_t);
+    size_t row_bytes = (size_t)header.num_rows * loaded.words * sizeof(uint64_t);
+    if (file.size() != sizeof(header) + index_bytes + row_bytes) return false;
+
+    loaded.row_of.resize(loaded.num_regions());
+    loaded.rows.resize((size_t)header.num_rows * loaded.words);
+    memcpy(loaded.row_of.data(), file.data() + sizeof(header), index_bytes);
+    memcpy(loaded.rows.data(), file.data() + sizeof(header) + index_bytes, row_bytes);
+    for (uint16_t row : loaded.row_of) {
+        if (row >= header.num_rows) return false;
+    }
+    pvs = std::move(loaded);
+    return true;
+}
+
+//write pvs to path under key, through a temporary file like nav_cache_write
+inline bool pvs_cache_write(const std::string &path, uint64_t key, const PotentiallyVisibleSet &pvs) {
+    PvsCacheHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, "NPVS", 4);
+    header.format = PVS_CACHE_FORMAT;
+    header.key = key;
+    header.region_size = pvs.region_size;
+    header.regions_x = pvs.regions_x;
+    header.regions_y = pvs.regions_y;
+    header.num_rows = pvs.num_rows();
+
+    std::string tmp = path + ".tmp";
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        if (!out) return false;
+        out.write((const char *)&header, sizeof(header));
+        out.write((const char *)pvs.row_of.data(), pvs.row_of.size() * sizeof(uint16_t));
+        out.write((const char *)pvs.rows.data(), pvs.rows.size() * sizeof(uint64_t));
+        if (!out) {
+            out.close();
+            std::remove(tmp.c_str());
+            return false;
+        }
+    }
+    std::remove(path.c_str());
+    return std::rename(tmp.c_str(), path.c_str()) == 0;
+}
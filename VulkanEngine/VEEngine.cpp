@@ -489,6 +489,68 @@ namespace ve {
 	};
 
 
+	//-------------------------------------------------------------------------------------------------------
+	//fixed step simulation
+
+	/**
+	*
+	* \brief Set the number of simulation steps per second.
+	*
+	* \param[in] hz Simulation steps per second, the step length is 1/hz.
+	*
+	*/
+	void VEEngine::setSimulationRate(double hz) {
+		assert(hz > 0.0);
+		m_simDt = 1.0 / hz;
+	}
+
+	/**
+	*
+	* \brief Set the most simulation steps that are run in one frame.
+	*
+	* If a frame takes longer than this many steps, e.g. in a debugger or while the window is dragged,
+	* the rest of the time is dropped and the game slows down instead of falling further behind.
+	*
+	* \param[in] steps Most steps per frame, at least 1.
+	*
+	*/
+	void VEEngine::setMaxSimulationSteps(uint32_t steps) {
+		m_maxSimSteps = std::max(steps, 1u);
+	}
+
+	/**
+	*
+	* \brief Run the fixed simulation steps for the time that has passed.
+	*
+	* The time of the frame is added to an accumulator, and simulation steps of length m_simDt are run
+	* while a whole step fits into it. Each step sends a VE_EVENT_SIMULATION_STEP, so the simulation
+	* advances the same way at any frame rate, and its cost does not grow with the refresh rate.
+	* The rest of the accumulator determines how far the frame lies between the last two simulation
+	* states, which the scene manager uses to interpolate the transforms of the moving nodes.
+	*
+	* \param[in] dt The delta time that has passed since the last loop.
+	*
+	*/
+	void VEEngine::simulate(double dt) {
+		m_simAccumulator += dt;
+
+		uint32_t steps = 0;
+		while (m_simAccumulator >= m_simDt && steps < m_maxSimSteps) {
+			getSceneManagerPointer()->storeSimulationTransforms(false);
+			veEvent event(veEvent::VE_EVENT_SIMULATION_STEP);
+			callListeners(m_simDt, event);
+			getSceneManagerPointer()->storeSimulationTransforms(true);
+
+			m_simAccumulator -= m_simDt;
+			steps++;
+		}
+		if (m_simAccumulator >= m_simDt) {					//too far behind, drop the time that was not simulated
+			m_simAccumulator = std::fmod(m_simAccumulator, m_simDt);
+		}
+		m_simAlpha = (float)(m_simAccumulator / m_simDt);
+	}
+
+
 
 	//-------------------------------------------------------------------------------------------------------
 	//render loop
@@ -498,7 +560,8 @@ namespace ve {
 	* \brief The main render loop.
 	*
 	* This is the main render loop. It performs time measurements, runs the event processing, checks whether the window
-	* size has changed (if so, informs the VEREnderer), and asks the VERenderer to draw and present one frame.
+	* size has changed (if so, informs the VEREnderer), runs the fixed simulation steps, and asks the VERenderer to draw
+	* and present one frame.
 	*
 	*/
 	void VEEngine::run() {
@@ -534,11 +597,22 @@ namespace ve {
 			processEvents(m_dt);				//process all current events, including pressed keys
 			m_AvgEventTime = vh::vhAverage(vh::vhTimeDuration(t_now), m_AvgEventTime);
 
+			//----------------------------------------------------------------------------------
+			//fixed step simulation
+
+			t_now = vh::vhTimeNow();
+			simulate(m_dt);						//run as many simulation steps as fit into the time that has passed
+			m_AvgSimTime = vh::vhAverage(vh::vhTimeDuration(t_now), m_AvgSimTime);
+
+			event.type = veEvent::VE_EVENT_RENDER;		//notify all listeners that the simulation of this frame is done
+			event.fdata1 = m_simAlpha;
+			callListeners(m_dt, event);
+
 			//----------------------------------------------------------------------------------
 			//update world matrices and send them to the GPU
 
 			t_now = vh::vhTimeNow();
-			getSceneManagerPointer()->updateSceneNodes( getRendererPointer()->getImageIndex());	//update scene node UBOs
+			getSceneManagerPointer()->updateSceneNodes( getRendererPointer()->getImageIndex(), m_simAlpha);	//update scene node UBOs
 			m_AvgUpdateTime = vh::vhAverage(vh::vhTimeDuration(t_now), m_AvgUpdateTime);
 
 			//----------------------------------------------------------------------------------
@@ -55,6 +55,10 @@ namespace ve {
 		double m_dt = 0.0;								///<Delta time since the last loop
 		double m_time = 0.0;							///<Absolute game time since start of the render loop
 		uint32_t m_loopCount = 0;						///<Counts up the render loop
+		double m_simDt = 1.0 / 60.0;					///<Length of a fixed simulation step (s)
+		uint32_t m_maxSimSteps = 5;						///<Most simulation steps per frame, the rest of a long frame is dropped
+		double m_simAccumulator = 0.0;					///<Time that has passed but is not simulated yet (s)
+		float m_simAlpha = 1.0f;						///<Fraction of a simulation step the rendered frame lies after the last step
 		ThreadPool *m_threadPool;						///<thread pool for parallel processing
 
 		//time statistics 
@@ -62,6 +66,7 @@ namespace ve {
 		float m_AvgFrameTime = 0.0f;					///<Average time per frame (s)
 		float m_AvgDrawTime = 0.0f;						///<Average time for baking cmd buffers and calling commit (s)
 		float m_AvgStartedTime = 0.0f;					///<Average time for processing frame started event
+		float m_AvgSimTime = 0.0f;						///<Average time for the simulation steps of a frame
 		float m_AvgEventTime = 0.0f;					///<Average time for processing windows events
 		float m_AvgEndedTime = 0.0f;					///<Average time for processing frame ended event
 		float m_AvgPresentTime = 0.0f;					///<Average time for presenting the frame
@@ -78,6 +83,7 @@ namespace ve {
 		void callListeners(double dt, veEvent event, std::vector<VEEventListener*> *list);	//Call all event listeners and give them certain event
 		void callListeners2( double dt, veEvent event, std::vector<VEEventListener*> *list, uint32_t startIdx, uint32_t endIdx);
 		void processEvents(double dt);			//Start handling all events
+		void simulate(double dt);				//Run the fixed simulation steps for the time that has passed
 		void windowSizeChanged();				//Callback for window if window size has changed
 
 		//startup routines, can be overloaded to create different managers
@@ -121,6 +127,16 @@ namespace ve {
 		VERenderer     * getRenderer();				//Return a pointer to the renderer instance
 		uint32_t		 getLoopCount();			//Return the number of the current render loop
 
+		//-----------------------------------------------------------------------------------------------
+		//fixed step simulation
+
+		void			setSimulationRate(double hz);			//Set the number of simulation steps per second
+		void			setMaxSimulationSteps(uint32_t steps);	//Set the most simulation steps that are run in one frame
+		///\returns the length of a simulation step (s)
+		double			getSimulationDt() { return m_simDt; };
+		///\returns the fraction of a simulation step the current frame lies after the last step
+		float			getSimulationAlpha() { return m_simAlpha; };
+
 		//-----------------------------------------------------------------------------------------------
 		//thread pool
 
@@ -140,6 +156,8 @@ namespace ve {
 		float			 getAvgStartedTime() { return m_AvgStartedTime; };
 		///\returns the average event time (s)
 		float			 getAvgEventTime() { return m_AvgEventTime; };
+		///\returns the average time for the simulation steps of a frame (s)
+		float			 getAvgSimTime() { return m_AvgSimTime; };
 		///\returns the average event time (s)
 		float			 getAvgDrawTime() { return m_AvgDrawTime; };
 		///\returns the average ended time (s)
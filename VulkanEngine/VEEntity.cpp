@@ -25,7 +25,8 @@ namespace ve {
 	*
 	*/
 
-	VESceneNode::VESceneNode(std::string name, glm::mat4 transf ) : VENamedClass(name), m_parent(nullptr), m_transform(transf) {
+	VESceneNode::VESceneNode(std::string name, glm::mat4 transf ) : VENamedClass(name), m_parent(nullptr), m_transform(transf),
+																		m_prevTransform(transf), m_simTransform(transf) {
 	}
 
 	/**
@@ -46,6 +47,25 @@ namespace ve {
 		m_transform = trans;
 	}
 
+	/**
+	*
+	* \brief Sets the scene node's local to parent transform, and draws it there right away.
+	*
+	* setTransform() inside a simulation step is blended from the old transform like any other move,
+	* so a node teleported across the scene would be drawn on the way for a frame. This also makes
+	* the transform the state before the step, so there is nothing to interpolate.
+	*
+	* \param[in] trans The new local to parent transform.
+	*
+	*/
+	void VESceneNode::snapTransform(glm::mat4 trans) {
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		m_transform = trans;
+		m_prevTransform = trans;
+		m_simTransform = trans;
+	}
+
 	/**
 	* \brief Sets the scene node's position.
 	*/
@@ -125,6 +145,70 @@ namespace ve {
 		return getWorldTransform2();
 	};
 
+	/**
+	*
+	* \brief Remember the transform of the scene node before or after a simulation step.
+	*
+	* The engine calls this for all scene nodes before and after each fixed simulation step. The transforms
+	* before and after the last step are the two states that getInterpolatedTransform() blends.
+	* A node created during the step has no state before it, so it starts at rest.
+	*
+	* \param[in] stepEnded False before the simulation step, true after it.
+	*
+	*/
+	void VESceneNode::storeSimulationTransform(bool stepEnded) {
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		if (!stepEnded) {
+			m_prevTransform = m_transform;
+			m_simStarted = true;
+			return;
+		}
+		if (!m_simStarted) m_prevTransform = m_transform;
+		m_simTransform = m_transform;
+		m_simStarted = false;
+	}
+
+	/**
+	*
+	* \brief Blend the transforms before and after the last simulation step.
+	*
+	* Translation and scale are interpolated linearly, the rotation with a slerp. Nodes that the last
+	* step did not move, and nodes that were changed since the step, e.g. a camera turned by the mouse,
+	* are not interpolated but use their current transform. A node scaled to (almost) zero along an
+	* axis has no rotation to slerp, only its translation is interpolated.
+	*
+	* \param[in] alpha Fraction of a simulation step that has passed since the last step, from 0 to 1.
+	* \returns the local to parent transform to draw the node with.
+	*
+	*/
+	glm::mat4 VESceneNode::getInterpolatedTransform(float alpha) {
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		if (m_transform != m_simTransform || m_prevTransform == m_simTransform) return m_transform;
+
+		glm::mat4 result = m_simTransform;
+		result[3] = glm::mix(m_prevTransform[3], m_simTransform[3], alpha);
+
+		glm::mat3 prev(m_prevTransform), next(m_simTransform);
+		if (prev == next) return result;					//only translated
+
+		glm::vec3 prevScale(glm::length(prev[0]), glm::length(prev[1]), glm::length(prev[2]));
+		glm::vec3 nextScale(glm::length(next[0]), glm::length(next[1]), glm::length(next[2]));
+		const float minScale = 1.0e-6f;
+		if (glm::any(glm::lessThan(glm::min(prevScale, nextScale), glm::vec3(minScale)))) return result;
+		for (int i = 0; i < 3; i++) {
+			prev[i] /= prevScale[i];
+			next[i] /= nextScale[i];
+		}
+		glm::mat3 rot = glm::mat3_cast(glm::slerp(glm::quat_cast(prev), glm::quat_cast(next), alpha));
+		glm::vec3 scale = glm::mix(prevScale, nextScale, alpha);
+		for (int i = 0; i < 3; i++) {
+			result[i] = glm::vec4(rot[i] * scale[i], 0.0f);
+		}
+		return result;
+	}
+
 	/**
 	*
 	* \brief An entity's world matrix is the local to parent transform multiplied by the parent's world matrix.
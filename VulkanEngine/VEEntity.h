@@ -44,6 +44,9 @@ namespace ve {
 
 	protected:
 		glm::mat4					m_transform = glm::mat4(1.0);	///<Transform from local to parent space, the engine uses Y-UP, Left-handed
+		glm::mat4					m_prevTransform = glm::mat4(1.0);	///<Transform before the last simulation step
+		glm::mat4					m_simTransform = glm::mat4(1.0);	///<Transform after the last simulation step
+		bool						m_simStarted = false;			///<Whether m_prevTransform was stored for the running simulation step
 		std::vector<VESceneNode *>	m_children;						///<List of entity children
 		VESceneNode *				m_parent = nullptr;				///<Pointer to entity parent
 		std::mutex					m_mutex;						///<Mutex for locking access to this node
@@ -57,6 +60,12 @@ namespace ve {
 		//--------------------------------------------------------------------------------------
 		glm::mat4	getWorldTransform2();				//Compute the world matrix
 
+		//--------------------------------------------------------------------------------------
+		//simulation states
+
+		void		storeSimulationTransform(bool stepEnded);	//Remember the transform before or after a simulation step
+		glm::mat4	getInterpolatedTransform(float alpha);		//Transform between the last two simulation states
+
 		//--------------------------------------------------------------------------------------
 		//UBO updates
 
@@ -86,6 +95,7 @@ namespace ve {
 		//transforms - must be synchronized with mutex
 
 		void		setTransform(glm::mat4 trans);		//Overwrite the transform and copy it to the UBO
+		void		snapTransform(glm::mat4 trans);		//Overwrite the transform without interpolating toward it, e.g. to teleport
 		glm::mat4	getTransform();						//Return local transform
 		void		setPosition(glm::vec3 pos);			//Set the position of the entity
 		glm::vec3	getPosition();						//Return the current position in parent space
@@ -56,6 +56,14 @@ namespace ve {
 		case veEvent::VE_EVENT_DELETE_NODE:
 			return onSceneNodeDeleted(event);
 			break;
+		case veEvent::VE_EVENT_SIMULATION_STEP:
+			onSimulationStep(event);
+			return false;
+			break;
+		case veEvent::VE_EVENT_RENDER:
+			onRender(event);
+			return false;
+			break;
 
 		default:
 			break;
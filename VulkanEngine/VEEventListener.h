@@ -49,6 +49,8 @@ namespace ve {
 			VE_EVENT_MOUSEBUTTON,		///<A mouse button event
 			VE_EVENT_MOUSESCROLL,		///<Mouse scroll event
 			VE_EVENT_DELETE_NODE,		///<A scene node was deleted
+			VE_EVENT_SIMULATION_STEP,	///<A simulation step of fixed length is run
+			VE_EVENT_RENDER,			///<The simulation is done for this frame, scene nodes are about to be drawn
 			VE_EVENT_LAST
 		};
 
@@ -112,6 +114,10 @@ namespace ve {
 		virtual void onFrameEnded(veEvent event) {};
 		///Draw an overlay
 		virtual void onDrawOverlay(veEvent event) {};
+		///Fixed simulation step, event.dt is always the simulation step length. Event cannot be consumed.
+		virtual void onSimulationStep(veEvent event) {};
+		///After the simulation steps of a frame, event.fdata1 is the interpolation factor. Event cannot be consumed.
+		virtual void onRender(veEvent event) {};
 
 		//-------------------------------------------------------------------------------
 		//window events
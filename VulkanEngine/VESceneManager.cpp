@@ -711,17 +711,19 @@ namespace ve {
 	*
 	* \brief Find all scene nodes without a parent, then update them and their children
 	*
-	* Makes this nodes and their children to copy their data to the GPU
+	* Makes this nodes and their children to copy their data to the GPU. Nodes moved by the simulation are drawn
+	* between their last two simulation states.
 	*
 	* \param[in] imageIndex Index of the swapchain image that is currently used.
+	* \param[in] alpha Fraction of a simulation step that has passed since the last step, 1 draws the last state.
 	*
 	*/
-	void VESceneManager::updateSceneNodes(uint32_t imageIndex) {
+	void VESceneManager::updateSceneNodes(uint32_t imageIndex, float alpha) {
 		std::lock_guard<std::mutex> lock(m_mutex);
 
 		m_lights.clear();												//light vector will be created dynamically
 
-		updateSceneNodes2(getRoot(), glm::mat4(1.0f), imageIndex);
+		updateSceneNodes2(getRoot(), glm::mat4(1.0f), imageIndex, alpha);
 
 		while (m_updateFutures.size() > 0) {							//gets all futures from the threads and waits for them
 			m_updateFutures.front().get();
@@ -743,10 +745,11 @@ namespace ve {
 	* \param[in] pNode Pointer to the node to start updating
 	* \param[in] parentWorldMatrix World Matrix of the parent, used as a start
 	* \param[in] imageIndex Index of the swapchain image that is currently used.
+	* \param[in] alpha Interpolation factor between the last two simulation states
 	*
 	*/
-	void VESceneManager::updateSceneNodes2(VESceneNode *pNode, glm::mat4 parentWorldMatrix, uint32_t imageIndex) {
-		glm::mat4 worldMatrix = parentWorldMatrix * pNode->getTransform();		//compute the world matrix
+	void VESceneManager::updateSceneNodes2(VESceneNode *pNode, glm::mat4 parentWorldMatrix, uint32_t imageIndex, float alpha) {
+		glm::mat4 worldMatrix = parentWorldMatrix * pNode->getInterpolatedTransform(alpha);		//compute the world matrix
 
 		pNode->updateUBO(worldMatrix, imageIndex);				//copy UBO data to the GPU
 
@@ -768,7 +771,7 @@ namespace ve {
 					startIdx = k*numChildrenPerThread;																			//start index for parallel run
 					endIdx = k == numThreads - 1 ? (uint32_t)pNode->m_children.size() - 1 : (k + 1)*numChildrenPerThread - 1;	//end index
 
-					auto future = tp->add( &VESceneManager::updateSceneNodes3, this, pNode->m_children, worldMatrix, startIdx, endIdx, imageIndex);	//add to threadpool
+					auto future = tp->add( &VESceneManager::updateSceneNodes3, this, pNode->m_children, worldMatrix, startIdx, endIdx, imageIndex, alpha);	//add to threadpool
 					{
 						static std::mutex mutex;
 						std::lock_guard<std::mutex> lock(mutex);
@@ -777,7 +780,7 @@ namespace ve {
 				}
 			}
 			else {
-				updateSceneNodes3(pNode->m_children, worldMatrix, 0, (uint32_t)pNode->m_children.size() - 1, imageIndex);	//do sequential update
+				updateSceneNodes3(pNode->m_children, worldMatrix, 0, (uint32_t)pNode->m_children.size() - 1, imageIndex, alpha);	//do sequential update
 			}
 		}
 	}
@@ -794,11 +797,44 @@ namespace ve {
 	* \param[in] startIdx Start index pointing to the child to start at in the children list
 	* \param[in] endIdx End index pointing to the child to end with in the children list
 	* \param[in] imageIndex Index of the swapchain image that is currently used.
+	* \param[in] alpha Interpolation factor between the last two simulation states
 	*
 	*/
-	void VESceneManager::updateSceneNodes3( std::vector<VESceneNode*> &children, glm::mat4 worldMatrix, uint32_t startIdx, uint32_t endIdx, uint32_t imageIndex) {
+	void VESceneManager::updateSceneNodes3( std::vector<VESceneNode*> &children, glm::mat4 worldMatrix, uint32_t startIdx, uint32_t endIdx, uint32_t imageIndex, float alpha) {
 		for (uint32_t i = startIdx; i <= endIdx; i++) {
-			updateSceneNodes2(children[i], worldMatrix, imageIndex);
+			updateSceneNodes2(children[i], worldMatrix, imageIndex, alpha);
+		}
+	}
+
+
+	/**
+	*
+	* \brief Remember the transforms of all scene nodes before or after a simulation step
+	*
+	* The transforms before and after the last step are the states the nodes are interpolated between when drawn.
+	*
+	* \param[in] stepEnded False before the simulation step, true after it.
+	*
+	*/
+	void VESceneManager::storeSimulationTransforms(bool stepEnded) {
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		storeSimulationTransforms2(getRoot(), stepEnded);
+	}
+
+
+	/**
+	*
+	* \brief Remember the transforms of a node and all its children before or after a simulation step
+	*
+	* \param[in] pNode Pointer to the node to start with
+	* \param[in] stepEnded False before the simulation step, true after it.
+	*
+	*/
+	void VESceneManager::storeSimulationTransforms2(VESceneNode *pNode, bool stepEnded) {
+		pNode->storeSimulationTransform(stepEnded);
+		for (auto pChild : pNode->m_children) {
+			storeSimulationTransforms2(pChild, stepEnded);
 		}
 	}
 
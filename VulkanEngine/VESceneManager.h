@@ -76,9 +76,11 @@ namespace ve {
 		VEMaterial *	createMaterial2(std::string name);
 		void			sceneGraphChanged2();					//tell renderer to rerecord the cmd buffers - internal
 		void			sceneGraphChanged3();					//tell renderer to rerecord the cmd buffers
-		void			updateSceneNodes(uint32_t imageIndex);
-		void			updateSceneNodes2(VESceneNode *pNode, glm::mat4 worldMatrix, uint32_t imageIndex);
-		void			updateSceneNodes3( std::vector<VESceneNode*> &children, glm::mat4 worldMatrix, uint32_t startIdx, uint32_t endIdx, uint32_t imageIndex);
+		void			updateSceneNodes(uint32_t imageIndex, float alpha = 1.0f);
+		void			updateSceneNodes2(VESceneNode *pNode, glm::mat4 worldMatrix, uint32_t imageIndex, float alpha);
+		void			updateSceneNodes3( std::vector<VESceneNode*> &children, glm::mat4 worldMatrix, uint32_t startIdx, uint32_t endIdx, uint32_t imageIndex, float alpha);
+		void			storeSimulationTransforms(bool stepEnded);			//remember the transforms of all nodes before or after a simulation step
+		void			storeSimulationTransforms2(VESceneNode *pNode, bool stepEnded);
 		void			setVisibility2(VESceneNode *pNode, bool flag);			//set a whole subtree visible or not
 		void			notifyEventListeners(VESceneNode *pNode);
 
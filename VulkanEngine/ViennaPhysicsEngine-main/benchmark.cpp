@@ -0,0 +1,281 @@
+//Physics benchmark
+//Times the narrow phase tests of the physics headers on seeded random colliders and checks them
+//against the plain GJK they replace, and prints one JSON document:
+//  - collide: the shape-pair kernels of collide.h against gjk with and without EPA
+//  - box_batch: the batched box overlap of box_batch.h at every instruction set against obb_overlap
+//  - pair_cache: warm-started gjk_cached of pair_cache.h against a cold one, on pairs moving around contact
+//Only the physics headers are linked, no Vulkan or GLFW. gjk_epa.h prints EPA runs that do not
+//converge to stdout, so write the document with --out to keep it clean.
+//
+//usage: physics_bench [--pairs N] [--seed S] [--out file.json]
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/ext.hpp>
+
+#include "collider.h"
+#include "gjk_epa.h"
+#include "collide.h"
+#include "box_batch.h"
+#include "pair_cache.h"
+
+using namespace std;
+
+typedef chrono::steady_clock bench_clock;
+
+const int BATCH_REPEATS = 50;       //overlap passes over the batch per instruction set
+const int CACHE_PAIRS = 400;        //pairs moving around contact in the pair cache runs
+const int CACHE_FRAMES = 300;
+
+
+struct BenchResult {
+    string test;
+    string variant;
+    int tests = 0;
+    double ns_per_test = 0.0;
+    double iterations = -1.0;        //mean GJK iterations, -1 if the variant cannot report them
+    int mismatches = 0;              //answers that differ from the reference of the test
+};
+
+static double elapsed_ns(bench_clock::time_point from, bench_clock::time_point to) {
+    return chrono::duration<double, nano>(to - from).count();
+}
+
+static float uniform(mt19937 &rng) {
+    return uniform_real_distribution<float>(-1.0f, 1.0f)(rng);
+}
+
+static vec3 random_vec3(mt19937 &rng) {
+    return vec3(uniform(rng), uniform(rng), uniform(rng));
+}
+
+static mat3 random_rotation(mt19937 &rng) {
+    vec3 axis = random_vec3(rng);
+    if (dot(axis, axis) < 1.0e-4f) axis = vec3(0.0f, 1.0f, 0.0f);
+    return mat3(rotate(mat4(1.0f), 3.14159265f * uniform(rng), axis));
+}
+
+static mat3 random_scale(mt19937 &rng) {
+    return mat3(scale(mat4(1.0f), vec3(1.0f) + 0.8f * random_vec3(rng)));
+}
+
+
+//collide.h
+
+//pairs of one kind: aligned boxes, rotated boxes or sphere against rotated box
+static void run_collide(const string &kind, int pairs, mt19937 &rng, vector<BenchResult> &results) {
+    bool rotated = kind != "box_aligned", spheres = kind == "sphere_box";
+    vector<Box> a, b;
+    vector<Sphere> s;
+    a.reserve(pairs);
+    b.reserve(pairs);
+    s.reserve(pairs);
+    for (int i = 0; i < pairs; i++) {
+        mat3 ra = rotated ? random_rotation(rng) : mat3(1.0f), rb = rotated ? random_rotation(rng) : mat3(1.0f);
+        a.emplace_back(1.5f * random_vec3(rng), ra * random_scale(rng));
+        b.emplace_back(1.5f * random_vec3(rng), rb * random_scale(rng));
+        s.emplace_back(1.5f * random_vec3(rng), 0.45f + 0.25f * uniform(rng));
+    }
+    auto first = [&](int i) -> Collider& { return spheres ? (Collider&)s[i] : (Collider&)a[i]; };
+
+    vector<char> reference(pairs);
+    for (int i = 0; i < pairs; i++) reference[i] = gjk(first(i), b[i]);
+
+    const char *variants[] = { "gjk_epa", "gjk", "collide" };
+    for (int v = 0; v < 3; v++) {
+        BenchResult r;
+        r.test = "collide_" + kind;
+        r.variant = variants[v];
+        r.tests = pairs;
+        vector<char> hit(pairs);
+        auto begin = bench_clock::now();
+        for (int i = 0; i < pairs; i++) {
+            vec3 mtv, point;
+            if (v == 0) hit[i] = gjk(first(i), b[i], mtv, point, true);
+            else if (v == 1) hit[i] = gjk(first(i), b[i]);
+            else hit[i] = collide(first(i), b[i]);
+        }
+        r.ns_per_test = elapsed_ns(begin, bench_clock::now()) / pairs;
+        for (int i = 0; i < pairs; i++) r.mismatches += hit[i] != reference[i];
+        results.push_back(r);
+    }
+}
+
+
+//box_batch.h
+
+static void run_box_batch(int boxes, mt19937 &rng, vector<BenchResult> &results) {
+    vector<Box> colliders;
+    colliders.reserve(boxes);
+    vector<OrientedBox> oriented(boxes);
+    BoxBatch batch;
+    for (int i = 0; i < boxes; i++) {
+        colliders.emplace_back(20.0f * random_vec3(rng), random_rotation(rng) * random_scale(rng));
+        oriented_box(colliders[i], oriented[i]);
+        batch.add(colliders[i], i);
+    }
+    Box query_box(vec3(1.0f, 2.0f, 3.0f), random_rotation(rng) * mat3(scale(mat4(1.0f), vec3(3.0f, 2.0f, 4.0f))));
+    OrientedBox query;
+    oriented_box(query_box, query);
+
+    vector<uint8_t> reference(boxes), hit(boxes);
+    BenchResult r;
+    r.test = "box_batch";
+    r.variant = "obb_overlap";
+    r.tests = boxes * BATCH_REPEATS;
+    auto begin = bench_clock::now();
+    for (int k = 0; k < BATCH_REPEATS; k++) {
+        for (int i = 0; i < boxes; i++) reference[i] = obb_overlap(query, oriented[i]);
+    }
+    r.ns_per_test = elapsed_ns(begin, bench_clock::now()) / r.tests;
+    results.push_back(r);
+
+    const char *names[] = { "scalar", "sse2", "avx" };
+    for (int level = BATCH_SCALAR; level <= BATCH_AVX; level++) {
+        batch.set_simd((BatchSimd)level);
+        if (batch.simd() != level) continue;        //not supported by this build or CPU
+        r = BenchResult();
+        r.test = "box_batch";
+        r.variant = names[level];
+        r.tests = boxes * BATCH_REPEATS;
+        begin = bench_clock::now();
+        for (int k = 0; k < BATCH_REPEATS; k++) batch.overlap(query, hit.data());
+        r.ns_per_test = elapsed_ns(begin, bench_clock::now()) / r.tests;
+        for (int i = 0; i < boxes; i++) r.mismatches += hit[i] != reference[i];
+        results.push_back(r);
+    }
+}
+
+
+//pair_cache.h
+
+//boxes and tetrahedra that drift and spin around contact, the same frames for every variant
+struct MovingPairs {
+    vector<Box> a;
+    vector<Tetrahedron> b;
+    vector<vec3> vel_a, vel_b, axis;
+
+    MovingPairs(int pairs, mt19937 &rng) {
+        a.reserve(pairs);
+        b.reserve(pairs);
+        for (int i = 0; i < pairs; i++) {
+            a.emplace_back(3.0f * random_vec3(rng), mat3(1.0f));
+            b.emplace_back(vec3(0.0f), vec3(1.0f, 0.0f, 0.0f), vec3(0.0f, 1.0f, 0.0f), vec3(0.0f, 0.0f, 1.0f));
+            b.back().m_pos = a.back().m_pos + 1.2f * random_vec3(rng);
+            vel_a.push_back(0.02f * random_vec3(rng));
+            vel_b.push_back(0.02f * random_vec3(rng));
+            axis.push_back(random_vec3(rng) + vec3(0.0f, 0.0f, 0.1f));
+        }
+    }
+
+    void move(int i, int frame) {
+        a[i].m_pos += vel_a[i] * sinf(0.05f * frame);
+        b[i].m_pos += vel_b[i] * cosf(0.05f * frame);
+        a[i].m_matRS = mat3(rotate(mat4(1.0f), 0.01f * frame, axis[i]));
+        a[i].m_matRS_inverse = inverse(a[i].m_matRS);
+    }
+};
+
+static void run_pair_cache(mt19937 &rng, vector<BenchResult> &results) {
+    unsigned seed = rng();
+    const char *variants[] = { "gjk", "gjk_cold", "gjk_cached" };
+    for (int v = 0; v < 3; v++) {
+        mt19937 frames(seed);
+        MovingPairs pairs(CACHE_PAIRS, frames);
+        PairCache cache;
+        BenchResult r;
+        r.test = "pair_cache";
+        r.variant = variants[v];
+        r.tests = CACHE_PAIRS * CACHE_FRAMES;
+        long iterations = 0;
+        double ns = 0.0;
+        for (int f = 0; f < CACHE_FRAMES; f++) {
+            cache.begin_frame();
+            for (int i = 0; i < CACHE_PAIRS; i++) {
+                pairs.move(i, f);
+                bool hit;
+                auto begin = bench_clock::now();
+                if (v == 0) {
+                    hit = gjk(pairs.a[i], pairs.b[i]);
+                } else {
+                    PairCacheEntry fresh;
+                    PairCacheEntry &entry = v == 1 ? fresh : cache.get(pairs.a[i], pairs.b[i]);
+                    hit = gjk_cached(pairs.a[i], pairs.b[i], entry);
+                    iterations += entry.m_iterations;
+                }
+                ns += elapsed_ns(begin, bench_clock::now());
+                r.mismatches += hit != gjk(pairs.a[i], pairs.b[i]);
+            }
+        }
+        r.ns_per_test = ns / r.tests;
+        if (v > 0) r.iterations = (double)iterations / r.tests;
+        results.push_back(r);
+    }
+}
+
+//output
+
+static void write_json(ostream &out, const vector<BenchResult> &results, int pairs, unsigned seed) {
+    out << "{\n";
+    out << "  \"seed\": " << seed << ",\n";
+    out << "  \"pairs\": " << pairs << ",\n";
+    out << "  \"runs\": [\n";
+    for (size_t i = 0; i < results.size(); i++) {
+        const BenchResult &r = results[i];
+        char line[512];
+        snprintf(line, sizeof(line),
+                 "    { \"test\": \"%s\", \"variant\": \"%s\", \"tests\": %d, \"ns_per_test\": %.2f, "
+                 "\"iterations\": %.2f, \"mismatches\": %d }%s\n",
+                 r.test.c_str(), r.variant.c_str(), r.tests, r.ns_per_test,
+                 r.iterations, r.mismatches, i + 1 < results.size() ? "," : "");
+        out << line;
+    }
+    out << "  ]\n";
+    out << "}\n";
+}
+
+
+int main(int argc, char *argv[]) {
+    int num_pairs = 20000;
+    unsigned seed = 12345;
+    string out_file;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--pairs") && i + 1 < argc) num_pairs = max(1, atoi(argv[++i]));
+        else if (!strcmp(argv[i], "--seed") && i + 1 < argc) seed = (unsigned)strtoul(argv[++i], nullptr, 10);
+        else if (!strcmp(argv[i], "--out") && i + 1 < argc) out_file = argv[++i];
+        else {
+            fprintf(stderr, "usage: %s [--pairs N] [--seed S] [--out file.json]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    //every collider only depends on the seed
+    mt19937 rng(seed);
+    vector<BenchResult> results;
+    for (const char *kind : { "box_aligned", "box_rotated", "sphere_box" }) {
+        fprintf(stderr, "collide %s\n", kind);
+        run_collide(kind, num_pairs, rng, results);
+    }
+    fprintf(stderr, "box_batch\n");
+    run_box_batch(num_pairs / 2, rng, results);
+    fprintf(stderr, "pair_cache\n");
+    run_pair_cache(rng, results);
+
+    if (out_file.empty()) {
+        write_json(cout, results, num_pairs, seed);
+    } else {
+        ofstream out(out_file);
+        write_json(out, results, num_pairs, seed);
+    }
+    return 0;
+}
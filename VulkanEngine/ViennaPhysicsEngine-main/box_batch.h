@@ -0,0 +1,338 @@
+#pragma once
+
+#include <cmath>
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define VPE_BATCH_SSE2 1
+#endif
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64)
+#include <immintrin.h>
+#define VPE_BATCH_AVX 1
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define VPE_TARGET_AVX          //MSVC compiles AVX intrinsics in any function
+#else
+#define VPE_TARGET_AVX __attribute__((target("avx")))
+#define VPE_TARGET_AVX_FLATTEN __attribute__((target("avx"), flatten))
+#endif
+#endif
+#ifndef VPE_TARGET_AVX_FLATTEN
+#define VPE_TARGET_AVX_FLATTEN VPE_TARGET_AVX
+#endif
+
+#include <glm/glm.hpp>
+#include <glm/ext.hpp>
+
+#include "collider.h"
+#include "collide.h"
+
+//Batched kernels for one oriented box against many Box/BBox colliders.
+//A BoxBatch stores its boxes as structure of arrays: one float array per center coordinate,
+//per component of the three unit axes and per half extent. A kernel loads the same field of
+//4 (SSE2) or 8 (AVX) boxes into one register, so it tests that many pairs per instruction:
+//  overlap()   the 15 axis SAT of collide.h; the 6 face axes run first and lanes that are all
+//              separated by then skip the 9 edge axes
+//  support()   the support point of every box along one direction
+//The instruction set is picked once at run time, AVX if the CPU and OS support it, else SSE2,
+//else a scalar loop over obb_overlap. All three give the same answers.
+//
+//Sheared boxes and other shapes cannot be stored, test those with collide().
+
+
+enum BatchSimd { BATCH_SCALAR = 0, BATCH_SSE2, BATCH_AVX };
+
+//best instruction set of this CPU
+inline BatchSimd batch_simd_detect() {
+#ifdef VPE_BATCH_AVX
+#if defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 1);
+    bool avx = (info[2] & (1 << 28)) != 0 && (info[2] & (1 << 27)) != 0;    //AVX and OSXSAVE
+    if (avx && (_xgetbv(0) & 6) == 6) return BATCH_AVX;                     //OS saves the YMM registers
+#else
+    __builtin_cpu_init();       //BoxBatch globals are constructed before main
+    if (__builtin_cpu_supports("avx")) return BATCH_AVX;
+#endif
+#endif
+#ifdef VPE_BATCH_SSE2
+    return BATCH_SSE2;
+#else
+    return BATCH_SCALAR;
+#endif
+}
+
+
+//lanes of one register, the kernels only use these operations
+
+struct ScalarPack {
+    enum { width = 1 };
+    float v;
+    static ScalarPack load( const float *p ) { return { *p }; }
+    static ScalarPack set1( float f ) { return { f }; }
+    void store( float *p ) const { *p = v; }
+    friend ScalarPack operator+( ScalarPack a, ScalarPack b ) { return { a.v + b.v }; }
+    friend ScalarPack operator-( ScalarPack a, ScalarPack b ) { return { a.v - b.v }; }
+    friend ScalarPack operator*( ScalarPack a, ScalarPack b ) { return { a.v * b.v }; }
+    friend ScalarPack operator|( ScalarPack a, ScalarPack b ) { return { (a.v != 0.0f || b.v != 0.0f) ? 1.0f : 0.0f }; }
+    friend ScalarPack abs( ScalarPack a ) { return { std::abs(a.v) }; }
+    friend ScalarPack cmp_gt( ScalarPack a, ScalarPack b ) { return { a.v > b.v ? 1.0f : 0.0f }; }
+    friend ScalarPack blend( ScalarPack m, ScalarPack a, ScalarPack b ) { return m.v != 0.0f ? a : b; }
+    int mask() const { return v != 0.0f; }
+};
+
+#ifdef VPE_BATCH_SSE2
+struct Sse2Pack {
+    enum { width = 4 };
+    __m128 v;
+    static Sse2Pack load( const float *p ) { return { _mm_loadu_ps(p) }; }
+    static Sse2Pack set1( float f ) { return { _mm_set1_ps(f) }; }
+    void store( float *p ) const { _mm_storeu_ps(p, v); }
+    friend Sse2Pack operator+( Sse2Pack a, Sse2Pack b ) { return { _mm_add_ps(a.v, b.v) }; }
+    friend Sse2Pack operator-( Sse2Pack a, Sse2Pack b ) { return { _mm_sub_ps(a.v, b.v) }; }
+    friend Sse2Pack operator*( Sse2Pack a, Sse2Pack b ) { return { _mm_mul_ps(a.v, b.v) }; }
+    friend Sse2Pack operator|( Sse2Pack a, Sse2Pack b ) { return { _mm_or_ps(a.v, b.v) }; }
+    friend Sse2Pack abs( Sse2Pack a ) { return { _mm_andnot_ps(_mm_set1_ps(-0.0f), a.v) }; }
+    friend Sse2Pack cmp_gt( Sse2Pack a, Sse2Pack b ) { return { _mm_cmpgt_ps(a.v, b.v) }; }
+    friend Sse2Pack blend( Sse2Pack m, Sse2Pack a, Sse2Pack b ) { return { _mm_or_ps(_mm_and_ps(m.v, a.v), _mm_andnot_ps(m.v, b.v)) }; }
+    int mask() const { return _mm_movemask_ps(v); }
+};
+#endif
+
+#ifdef VPE_BATCH_AVX
+struct AvxPack {
+    enum { width = 8 };
+    __m256 v;
+    VPE_TARGET_AVX static AvxPack load( const float *p ) { return { _mm256_loadu_ps(p) }; }
+    VPE_TARGET_AVX static AvxPack set1( float f ) { return { _mm256_set1_ps(f) }; }
+    VPE_TARGET_AVX void store( float *p ) const { _mm256_storeu_ps(p, v); }
+    VPE_TARGET_AVX friend AvxPack operator+( AvxPack a, AvxPack b ) { return { _mm256_add_ps(a.v, b.v) }; }
+    VPE_TARGET_AVX friend AvxPack operator-( AvxPack a, AvxPack b ) { return { _mm256_sub_ps(a.v, b.v) }; }
+    VPE_TARGET_AVX friend AvxPack operator*( AvxPack a, AvxPack b ) { return { _mm256_mul_ps(a.v, b.v) }; }
+    VPE_TARGET_AVX friend AvxPack operator|( AvxPack a, AvxPack b ) { return { _mm256_or_ps(a.v, b.v) }; }
+    VPE_TARGET_AVX friend AvxPack abs( AvxPack a ) { return { _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a.v) }; }
+    VPE_TARGET_AVX friend AvxPack cmp_gt( AvxPack a, AvxPack b ) { return { _mm256_cmp_ps(a.v, b.v, _CMP_GT_OQ) }; }
+    VPE_TARGET_AVX friend AvxPack blend( AvxPack m, AvxPack a, AvxPack b ) { return { _mm256_blendv_ps(b.v, a.v, m.v) }; }
+    VPE_TARGET_AVX int mask() const { return _mm256_movemask_ps(v); }
+};
+#endif
+
+
+//fields of a box in the SoA arrays
+enum BatchField {
+    BATCH_CX = 0, BATCH_CY, BATCH_CZ,       //center
+    BATCH_U0 = 3,                           //axis j, component k at BATCH_U0 + 3 * j + k
+    BATCH_HX = 12, BATCH_HY, BATCH_HZ,      //half extents along the axes
+    BATCH_FIELDS
+};
+
+constexpr int BATCH_PAD = 8;                //arrays are padded to this many lanes, the widest register
+
+//overlap of box a with boxes [0, n) of fields, hits[i] = 1 if box i overlaps a
+template<typename P>
+inline void batch_overlap_kernel( const float *const *f, int n, const OrientedBox &a, uint8_t *hits ) {
+    P ac[3] = { P::set1(a.m_center.x), P::set1(a.m_center.y), P::set1(a.m_center.z) };
+    P au[3][3], ea[3];
+    for (int i = 0; i < 3; i++) {
+        au[i][0] = P::set1(a.m_axis[i].x);
+        au[i][1] = P::set1(a.m_axis[i].y);
+        au[i][2] = P::set1(a.m_axis[i].z);
+        ea[i] = P::set1(a.m_half[i]);
+    }
+    P eps = P::set1(EPS);
+    int all = (1 << P::width) - 1;
+
+    for (int l = 0; l < n; l += P::width) {
+        P R[3][3], absR[3][3];
+        for (int j = 0; j < 3; j++) {
+            P bx = P::load(f[BATCH_U0 + 3 * j] + l), by = P::load(f[BATCH_U0 + 3 * j + 1] + l), bz = P::load(f[BATCH_U0 + 3 * j + 2] + l);
+            for (int i = 0; i < 3; i++) {
+                R[i][j] = au[i][0] * bx + au[i][1] * by + au[i][2] * bz;
+                absR[i][j] = abs(R[i][j]) + eps;
+            }
+        }
+        P d[3] = { P::load(f[BATCH_CX] + l) - ac[0], P::load(f[BATCH_CY] + l) - ac[1], P::load(f[BATCH_CZ] + l) - ac[2] };
+        P t[3], eb[3] = { P::load(f[BATCH_HX] + l), P::load(f[BATCH_HY] + l), P::load(f[BATCH_HZ] + l) };
+        for (int i = 0; i < 3; i++) t[i] = au[i][0] * d[0] + au[i][1] * d[1] + au[i][2] * d[2];
+
+        //the sums are grouped as in obb_overlap, so every instruction set rounds the same way
+        P separated = cmp_gt(abs(t[0]), ea[0] + (eb[0] * absR[0][0] + eb[1] * absR[0][1] + eb[2] * absR[0][2]));
+        for (int i = 1; i < 3; i++) {
+            separated = separated | cmp_gt(abs(t[i]), ea[i] + (eb[0] * absR[i][0] + eb[1] * absR[i][1] + eb[2] * absR[i][2]));
+        }
+        for (int j = 0; j < 3; j++) {
+            P ra = ea[0] * absR[0][j] + ea[1] * absR[1][j] + ea[2] * absR[2][j];
+            separated = separated | cmp_gt(abs(t[0] * R[0][j] + t[1] * R[1][j] + t[2] * R[2][j]), ra + eb[j]);
+        }
+        if (separated.mask() != all) {
+            for (int i = 0; i < 3; i++) {
+                int i1 = (i + 1) % 3, i2 = (i + 2) % 3;
+                for (int j = 0; j < 3; j++) {
+                    int j1 = (j + 1) % 3, j2 = (j + 2) % 3;
+                    P r = (ea[i1] * absR[i2][j] + ea[i2] * absR[i1][j]) + (eb[j1] * absR[i][j2] + eb[j2] * absR[i][j1]);
+                    separated = separated | cmp_gt(abs(t[i2] * R[i1][j] - t[i1] * R[i2][j]), r);
+                }
+            }
+        }
+        int m = separated.mask();
+        for (int k = 0; k < P::width && l + k < n; k++) hits[l + k] = (m >> k & 1) == 0;
+    }
+}
+
+//support point of boxes [0, n) of fields along dir, written to x, y, z (padded to P::width)
+template<typename P>
+inline void batch_support_kernel( const float *const *f, int n, vec3 dir, float *x, float *y, float *z ) {
+    P dx = P::set1(dir.x), dy = P::set1(dir.y), dz = P::set1(dir.z), zero = P::set1(0.0f);
+    for (int l = 0; l < n; l += P::width) {
+        P p[3] = { P::load(f[BATCH_CX] + l), P::load(f[BATCH_CY] + l), P::load(f[BATCH_CZ] + l) };
+        for (int j = 0; j < 3; j++) {
+            P ux = P::load(f[BATCH_U0 + 3 * j] + l), uy = P::load(f[BATCH_U0 + 3 * j + 1] + l), uz = P::load(f[BATCH_U0 + 3 * j + 2] + l);
+            P h = P::load(f[BATCH_HX + j] + l);
+            h = blend(cmp_gt(dx * ux + dy * uy + dz * uz, zero), h, zero - h);    //the max corner, like BBox::support
+            p[0] = p[0] + h * ux;
+            p[1] = p[1] + h * uy;
+            p[2] = p[2] + h * uz;
+        }
+        p[0].store(x + l);
+        p[1].store(y + l);
+        p[2].store(z + l);
+    }
+}
+
+//one entry point per instruction set, the AVX one is compiled for AVX with the kernel inlined
+//one pair at a time obb_overlap is faster, it stops at the first separating axis
+inline void batch_overlap_scalar( const float *const *f, int n, const OrientedBox &a, uint8_t *hits ) {
+    for (int l = 0; l < n; l++) {
+        OrientedBox b;
+        b.m_center = vec3(f[BATCH_CX][l], f[BATCH_CY][l], f[BATCH_CZ][l]);
+        for (int j = 0; j < 3; j++) {
+            b.m_axis[j] = vec3(f[BATCH_U0 + 3 * j][l], f[BATCH_U0 + 3 * j + 1][l], f[BATCH_U0 + 3 * j + 2][l]);
+            b.m_half[j] = f[BATCH_HX + j][l];
+        }
+        hits[l] = obb_overlap(a, b);
+    }
+}
+inline void batch_support_scalar( const float *const *f, int n, vec3 dir, float *x, float *y, float *z ) {
+    batch_support_kernel<ScalarPack>(f, n, dir, x, y, z);
+}
+#ifdef VPE_BATCH_SSE2
+inline void batch_overlap_sse2( const float *const *f, int n, const OrientedBox &a, uint8_t *hits ) {
+    batch_overlap_kernel<Sse2Pack>(f, n, a, hits);
+}
+inline void batch_support_sse2( const float *const *f, int n, vec3 dir, float *x, float *y, float *z ) {
+    batch_support_kernel<Sse2Pack>(f, n, dir, x, y, z);
+}
+#endif
+#ifdef VPE_BATCH_AVX
+VPE_TARGET_AVX_FLATTEN inline void batch_overlap_avx( const float *const *f, int n, const OrientedBox &a, uint8_t *hits ) {
+    batch_overlap_kernel<AvxPack>(f, n, a, hits);
+}
+VPE_TARGET_AVX_FLATTEN inline void batch_support_avx( const float *const *f, int n, vec3 dir, float *x, float *y, float *z ) {
+    batch_support_kernel<AvxPack>(f, n, dir, x, y, z);
+}
+#endif
+
+
+class BoxBatch {
+public:
+    BoxBatch() { set_simd(batch_simd_detect()); }
+
+    //use another instruction set, e.g. to compare them, falls back to what the build supports
+    void set_simd( BatchSimd simd ) {
+        m_simd = BATCH_SCALAR;
+        m_overlap = batch_overlap_scalar;
+        m_support = batch_support_scalar;
+#ifdef VPE_BATCH_SSE2
+        if (simd >= BATCH_SSE2) {
+            m_simd = BATCH_SSE2;
+            m_overlap = batch_overlap_sse2;
+            m_support = batch_support_sse2;
+        }
+#endif
+#ifdef VPE_BATCH_AVX
+        if (simd >= BATCH_AVX) {
+            m_simd = BATCH_AVX;
+            m_overlap = batch_overlap_avx;
+            m_support = batch_support_avx;
+        }
+#endif
+    }
+    BatchSimd simd() const { return m_simd; }
+
+    void clear() {
+        m_size = 0;
+        m_users.clear();
+        for (auto &field : m_fields) field.clear();
+    }
+
+    //add a Box or BBox, false if it is another shape or sheared
+    bool add( Collider &c, int user ) {
+        OrientedBox box;
+        if ((c.m_shape != SHAPE_BOX && c.m_shape != SHAPE_BBOX) || !oriented_box(c, box)) return false;
+        add(box, user);
+        return true;
+    }
+
+    void add( const OrientedBox &box, int user ) {
+        int i = m_size++;
+        m_users.push_back(user);
+        for (auto &field : m_fields) field.resize((m_size + BATCH_PAD - 1) / BATCH_PAD * BATCH_PAD, 0.0f);
+        m_fields[BATCH_CX][i] = box.m_center.x;
+        m_fields[BATCH_CY][i] = box.m_center.y;
+        m_fields[BATCH_CZ][i] = box.m_center.z;
+        for (int j = 0; j < 3; j++) {
+            m_fields[BATCH_U0 + 3 * j][i] = box.m_axis[j].x;
+            m_fields[BATCH_U0 + 3 * j + 1][i] = box.m_axis[j].y;
+            m_fields[BATCH_U0 + 3 * j + 2][i] = box.m_axis[j].z;
+            m_fields[BATCH_HX + j][i] = box.m_half[j];
+        }
+    }
+
+    int size() const { return m_size; }
+    int user( int i ) const { return m_users[i]; }
+
+    //hits[i] = 1 if box i overlaps box, for all i < size()
+    void overlap( const OrientedBox &box, uint8_t *hits ) const {
+        const float *f[BATCH_FIELDS];
+        for (int k = 0; k < BATCH_FIELDS; k++) f[k] = m_fields[k].data();
+        m_overlap(f, m_size, box, hits);
+    }
+
+    //the boxes of candidates (e.g. from a broad phase query) that overlap box, appended to hits
+    //the candidates are gathered BATCH_PAD at a time into registers sized arrays
+    void overlap( const OrientedBox &box, const int *candidates, int n, std::vector<int> &hits ) const {
+        alignas(32) float lanes[BATCH_FIELDS][BATCH_PAD];
+        const float *f[BATCH_FIELDS];
+        for (int k = 0; k < BATCH_FIELDS; k++) f[k] = lanes[k];
+        uint8_t hit[BATCH_PAD];
+        for (int c = 0; c < n; c += BATCH_PAD) {
+            int count = std::min(BATCH_PAD, n - c);
+            for (int k = 0; k < BATCH_FIELDS; k++) {
+                for (int l = 0; l < BATCH_PAD; l++) lanes[k][l] = l < count ? m_fields[k][candidates[c + l]] : 0.0f;
+            }
+            m_overlap(f, count, box, hit);
+            for (int l = 0; l < count; l++) {
+                if (hit[l]) hits.push_back(candidates[c + l]);
+            }
+        }
+    }
+
+    //support point of every box along dir, x, y and z need room for size() rounded up to BATCH_PAD
+    void support( vec3 dir, float *x, float *y, float *z ) const {
+        const float *f[BATCH_FIELDS];
+        for (int k = 0; k < BATCH_FIELDS; k++) f[k] = m_fields[k].data();
+        m_support(f, m_size, dir, x, y, z);
+    }
+
+private:
+    int m_size = 0;
+    std::vector<int> m_users;
+    std::vector<float> m_fields[BATCH_FIELDS];
+    BatchSimd m_simd = BATCH_SCALAR;
+    void (*m_overlap)( const float *const *, int, const OrientedBox &, uint8_t * ) = nullptr;
+    void (*m_support)( const float *const *, int, vec3, float *, float *, float * ) = nullptr;
+};
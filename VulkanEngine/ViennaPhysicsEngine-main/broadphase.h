@@ -0,0 +1,323 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/ext.hpp>
+
+#include "collider.h"
+
+//Broad phase: a dynamic AABB tree (bounding volume hierarchy) over the colliders of a scene.
+//Every collider is a leaf holding a fat AABB, its bounds grown by a margin. Inner nodes bound
+//their two children, so a query only descends into subtrees whose box overlaps the query box
+//and costs O(log n) instead of testing every collider.
+//New leaves go next to the sibling that grows the tree's surface area the least, and the
+//path back to the root is refit and rebalanced with tree rotations (as in Box2D's b2DynamicTree).
+//A moving collider only touches the tree when it leaves its fat AABB; then its leaf is
+//removed and reinserted with a new fat box that is also stretched along the displacement.
+//
+//Narrow phase tests (gjk, sat) should only run on the candidates a query reports.
+//Each proxy carries a user value (e.g. an index into the game's collider list) and a layer
+//mask, queries skip proxies whose layer does not match their mask.
+
+
+struct AABB {
+    vec3 m_min{ 0.0f }, m_max{ 0.0f };
+
+    bool overlaps(const AABB &b) const {
+        return m_min.x <= b.m_max.x && m_max.x >= b.m_min.x &&
+               m_min.y <= b.m_max.y && m_max.y >= b.m_min.y &&
+               m_min.z <= b.m_max.z && m_max.z >= b.m_min.z;
+    }
+
+    bool contains(const AABB &b) const {
+        return m_min.x <= b.m_min.x && m_min.y <= b.m_min.y && m_min.z <= b.m_min.z &&
+               m_max.x >= b.m_max.x && m_max.y >= b.m_max.y && m_max.z >= b.m_max.z;
+    }
+
+    float surface_area() const {
+        vec3 d = m_max - m_min;
+        return 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+    }
+};
+
+inline AABB merge(const AABB &a, const AABB &b) {
+    return { min(a.m_min, b.m_min), max(a.m_max, b.m_max) };
+}
+
+//world space bounds of any collider, from its support points along the six axes
+inline AABB collider_aabb(Collider &c) {
+    AABB box;
+    box.m_min = { c.support(vec3(-1, 0, 0)).x, c.support(vec3(0, -1, 0)).y, c.support(vec3(0, 0, -1)).z };
+    box.m_max = { c.support(vec3( 1, 0, 0)).x, c.support(vec3(0,  1, 0)).y, c.support(vec3(0, 0,  1)).z };
+    return box;
+}
+
+
+constexpr int BROADPHASE_NULL = -1;
+constexpr uint32_t BROADPHASE_ALL_LAYERS = 0xffffffff;
+
+class AABBTree {
+public:
+    AABBTree( float margin = 0.5f, float displacement_factor = 2.0f )
+        : m_margin(margin), m_displacement_factor(displacement_factor) {}
+
+    //add a collider with bounds box, returns its proxy id
+    int insert( const AABB &box, int user, uint32_t layer = 1 ) {
+        int proxy = allocate_node();
+        Node &n = m_nodes[proxy];
+        n.m_box = fatten(box, vec3(0.0f));
+        n.m_user = user;
+        n.m_layer = layer;
+        n.m_height = 0;
+        insert_leaf(proxy);
+        m_num_proxies++;
+        return proxy;
+    }
+
+    void remove( int proxy ) {
+        remove_leaf(proxy);
+        free_node(proxy);
+        m_num_proxies--;
+    }
+
+    //the collider of proxy now has bounds box after moving by displacement
+    //returns true if the leaf had to be reinserted, false if box is still inside its fat AABB
+    bool update( int proxy, const AABB &box, vec3 displacement = vec3(0.0f) ) {
+        if (m_nodes[proxy].m_box.contains(box)) return false;
+        remove_leaf(proxy);
+        m_nodes[proxy].m_box = fatten(box, displacement);
+        insert_leaf(proxy);
+        return true;
+    }
+
+    void clear() {
+        m_nodes.clear();
+        m_root = BROADPHASE_NULL;
+        m_free = BROADPHASE_NULL;
+        m_num_proxies = 0;
+    }
+
+    int user( int proxy ) const { return m_nodes[proxy].m_user; }
+    uint32_t layer( int proxy ) const { return m_nodes[proxy].m_layer; }
+    const AABB & fat_aabb( int proxy ) const { return m_nodes[proxy].m_box; }
+    int size() const { return m_num_proxies; }
+    int height() const { return m_root == BROADPHASE_NULL ? 0 : m_nodes[m_root].m_height; }
+
+    //call f(proxy) for every proxy in a matching layer whose fat AABB overlaps box
+    //f may return false to stop the query
+    template<typename F>
+    void query( const AABB &box, uint32_t mask, F&& f ) const {
+        if (m_root == BROADPHASE_NULL) return;
+        thread_local std::vector<int> stack;
+        stack.clear();
+        stack.push_back(m_root);
+        while (!stack.empty()) {
+            const Node &n = m_nodes[stack.back()];
+            int index = stack.back();
+            stack.pop_back();
+            if (!n.m_box.overlaps(box) || !(n.m_layer & mask)) continue;
+            if (n.leaf()) {
+                if (!f(index)) return;
+            } else {
+                stack.push_back(n.m_child1);
+                stack.push_back(n.m_child2);
+            }
+        }
+    }
+
+    //call f(proxy_a, proxy_b) once for every pair of proxies whose fat AABBs overlap
+    //and whose layers both match mask
+    template<typename F>
+    void query_pairs( F&& f, uint32_t mask = BROADPHASE_ALL_LAYERS ) const {
+        for (int a = 0; a < (int)m_nodes.size(); a++) {
+            const Node &n = m_nodes[a];
+            if (!n.leaf() || n.m_height < 0 || !(n.m_layer & mask)) continue;
+            query(n.m_box, mask, [&](int b) {
+                if (b > a) f(a, b);
+                return true;
+            });
+        }
+    }
+
+private:
+    struct Node {
+        AABB     m_box;
+        int      m_parent = BROADPHASE_NULL;    //next free node while the node is unused
+        int      m_child1 = BROADPHASE_NULL;
+        int      m_child2 = BROADPHASE_NULL;
+        int      m_height = -1;                 //0 for leaves, -1 for free nodes
+        int      m_user = -1;
+        uint32_t m_layer = 0;                   //leaf: its layer, inner node: union of its children
+
+        bool leaf() const { return m_child1 == BROADPHASE_NULL; }
+    };
+
+    AABB fatten( const AABB &box, vec3 displacement ) const {
+        AABB fat{ box.m_min - vec3(m_margin), box.m_max + vec3(m_margin) };
+        vec3 d = displacement * m_displacement_factor;
+        fat.m_min += min(d, vec3(0.0f));
+        fat.m_max += max(d, vec3(0.0f));
+        return fat;
+    }
+
+    int allocate_node() {
+        if (m_free == BROADPHASE_NULL) {
+            m_nodes.emplace_back();
+            return (int)m_nodes.size() - 1;
+        }
+        int index = m_free;
+        m_free = m_nodes[index].m_parent;
+        m_nodes[index] = Node();
+        return index;
+    }
+
+    void free_node( int index ) {
+        m_nodes[index] = Node();
+        m_nodes[index].m_parent = m_free;
+        m_free = index;
+    }
+
+    void insert_leaf( int leaf ) {
+        m_nodes[leaf].m_parent = BROADPHASE_NULL;
+        if (m_root == BROADPHASE_NULL) {
+            m_root = leaf;
+            return;
+        }
+
+        //descend to the sibling with the least surface area cost
+        AABB leaf_box = m_nodes[leaf].m_box;
+        int index = m_root;
+        while (!m_nodes[index].leaf()) {
+            const Node &n = m_nodes[index];
+            float area = n.m_box.surface_area();
+            float combined = merge(n.m_box, leaf_box).surface_area();
+            float cost = 2.0f * combined;                   //new parent of this node and the leaf
+            float inheritance = 2.0f * (combined - area);   //growth every ancestor pays below here
+
+            auto child_cost = [&](int c) {
+                const Node &child = m_nodes[c];
+                float grown = merge(child.m_box, leaf_box).surface_area();
+                return (child.leaf() ? grown : grown - child.m_box.surface_area()) + inheritance;
+            };
+            float cost1 = child_cost(n.m_child1);
+            float cost2 = child_cost(n.m_child2);
+            if (cost < cost1 && cost < cost2) break;
+            index = cost1 < cost2 ? n.m_child1 : n.m_child2;
+        }
+
+        int sibling = index;
+        int old_parent = m_nodes[sibling].m_parent;
+        int new_parent = allocate_node();
+        Node &p = m_nodes[new_parent];
+        p.m_parent = old_parent;
+        p.m_child1 = sibling;
+        p.m_child2 = leaf;
+        p.m_height = m_nodes[sibling].m_height + 1;
+        m_nodes[sibling].m_parent = new_parent;
+        m_nodes[leaf].m_parent = new_parent;
+        if (old_parent == BROADPHASE_NULL) {
+            m_root = new_parent;
+        } else if (m_nodes[old_parent].m_child1 == sibling) {
+            m_nodes[old_parent].m_child1 = new_parent;
+        } else {
+            m_nodes[old_parent].m_child2 = new_parent;
+        }
+        refit(new_parent);
+    }
+
+    void remove_leaf( int leaf ) {
+        if (leaf == m_root) {
+            m_root = BROADPHASE_NULL;
+            return;
+        }
+        int parent = m_nodes[leaf].m_parent;
+        int grand_parent = m_nodes[parent].m_parent;
+        int sibling = m_nodes[parent].m_child1 == leaf ? m_nodes[parent].m_child2 : m_nodes[parent].m_child1;
+
+        if (grand_parent == BROADPHASE_NULL) {
+            m_root = sibling;
+            m_nodes[sibling].m_parent = BROADPHASE_NULL;
+            free_node(parent);
+            return;
+        }
+        if (m_nodes[grand_parent].m_child1 == parent) m_nodes[grand_parent].m_child1 = sibling;
+        else m_nodes[grand_parent].m_child2 = sibling;
+        m_nodes[sibling].m_parent = grand_parent;
+        free_node(parent);
+        refit(grand_parent);
+    }
+
+    //recompute bounds, layers and heights from index up to the root, rebalancing on the way
+    void refit( int index ) {
+        while (index != BROADPHASE_NULL) {
+            index = balance(index);
+            Node &n = m_nodes[index];
+            const Node &c1 = m_nodes[n.m_child1];
+            const Node &c2 = m_nodes[n.m_child2];
+            n.m_box = merge(c1.m_box, c2.m_box);
+            n.m_layer = c1.m_layer | c2.m_layer;
+            n.m_height = 1 + std::max(c1.m_height, c2.m_height);
+            index = n.m_parent;
+        }
+    }
+
+    //if the subtrees of a differ in height by more than one, rotate the higher child up
+    //returns the node that now takes the place of a
+    int balance( int a ) {
+        Node &A = m_nodes[a];
+        if (A.leaf() || A.m_height < 2) return a;
+
+        int b = A.m_child1, c = A.m_child2;
+        int diff = m_nodes[c].m_height - m_nodes[b].m_height;
+        if (diff > 1) return rotate(a, c, b);
+        if (diff < -1) return rotate(a, b, c);
+        return a;
+    }
+
+    //move child up into the place of a, a takes the lower of child's children and keeps other
+    int rotate( int a, int child, int other ) {
+        Node &A = m_nodes[a];
+        Node &C = m_nodes[child];
+        int f = C.m_child1, g = C.m_child2;
+
+        C.m_child1 = a;
+        C.m_parent = A.m_parent;
+        A.m_parent = child;
+        if (C.m_parent == BROADPHASE_NULL) {
+            m_root = child;
+        } else if (m_nodes[C.m_parent].m_child1 == a) {
+            m_nodes[C.m_parent].m_child1 = child;
+        } else {
+            m_nodes[C.m_parent].m_child2 = child;
+        }
+
+        //the higher grandchild stays with child, the lower one replaces child below a
+        int keep = m_nodes[f].m_height > m_nodes[g].m_height ? f : g;
+        int give = keep == f ? g : f;
+        C.m_child2 = keep;
+        if (A.m_child1 == child) A.m_child1 = give;
+        else A.m_child2 = give;
+        m_nodes[give].m_parent = a;
+
+        const Node &o = m_nodes[other];
+        const Node &gv = m_nodes[give];
+        A.m_box = merge(o.m_box, gv.m_box);
+        A.m_layer = o.m_layer | gv.m_layer;
+        A.m_height = 1 + std::max(o.m_height, gv.m_height);
+
+        const Node &k = m_nodes[keep];
+        C.m_box = merge(A.m_box, k.m_box);
+        C.m_layer = A.m_layer | k.m_layer;
+        C.m_height = 1 + std::max(A.m_height, k.m_height);
+        return child;
+    }
+
+    std::vector<Node> m_nodes;
+    int   m_root = BROADPHASE_NULL;
+    int   m_free = BROADPHASE_NULL;        //head of the free list, linked through m_parent
+    int   m_num_proxies = 0;
+    float m_margin;                         //fat AABBs are this much larger on every side
+    float m_displacement_factor;            //and stretched by this many frames of displacement
+};
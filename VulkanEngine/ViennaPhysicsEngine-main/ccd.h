@@ -0,0 +1,109 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/ext.hpp>
+
+#include "collider.h"
+#include "distance.h"
+#include "broadphase.h"
+
+//Continuous collision detection for colliders that translate during a step.
+//An overlap test at the end of a step misses a fast collider that jumps over another one
+//(tunneling). The queries here sweep the colliders along their motion instead.
+//
+//time_of_impact uses conservative advancement (Mirtich 1996): with the distance d of the colliders
+//and the speed s at which they close in along the direction of their closest points, they cannot
+//touch before d / s, so time advances by that much and the distance is measured again. For
+//translations this reaches the first touching time from below, in one step for faces and in a
+//few for edges and vertices. The colliders are not moved, the motion enters the distance query
+//as an offset, so the queries are re-entrant.
+//
+//ray_cast and shape_cast sweep through a broad phase, an AABBTree or a SpatialHash: the swept
+//AABB of the motion selects the candidates, time_of_impact tests them.
+
+
+constexpr int   CCD_MAX_ITERATIONS = 32;
+constexpr float CCD_TOLERANCE = 1.0e-3f;            //distance that counts as touching
+
+
+//first time t in [0, 1] at which coll1 moving by motion1 and coll2 moving by motion2 touch
+//normal points from coll2 toward coll1 at that time; false if they do not touch during the motion
+inline bool time_of_impact( Collider &coll1, vec3 motion1, Collider &coll2, vec3 motion2
+                          , float &toi, vec3 &normal, float tolerance = CCD_TOLERANCE ) {
+    vec3 r = motion1 - motion2;         //motion of coll1 seen from coll2
+    float t = 0.0f;
+    for (int iterations = 0; iterations < CCD_MAX_ITERATIONS; iterations++) {
+        vec3 closest;
+        float d = gjk_distance(coll1, coll2, -r * t, closest);
+        if (d <= tolerance) {
+            toi = t;
+            if (d > EPS) normal = -closest / d;
+            else normal = dot(r, r) > 0.0f ? -normalize(r) : vec3(0.0f, 1.0f, 0.0f);   //overlapping at the start
+            return true;
+        }
+        float speed = dot(r, closest) / d;          //how fast the gap closes
+        if (speed <= 0.0f) return false;            //moving apart along the gap, for translations for good
+        t += (d - 0.5f * tolerance) / speed;
+        if (t > 1.0f) return false;
+    }
+    return false;
+}
+
+//sweep of a static coll2
+inline bool time_of_impact( Collider &coll1, vec3 motion, Collider &coll2, float &toi, vec3 &normal ) {
+    return time_of_impact(coll1, motion, coll2, vec3(0.0f), toi, normal);
+}
+
+
+//a collider hit by a cast
+struct CastHit {
+    int   m_item = -1;              //proxy or item of the broad phase
+    float m_toi = 1.0f;             //fraction of the motion
+    vec3  m_normal{ 0.0f };         //points away from the hit collider
+};
+
+//bounds of a collider over its motion
+inline AABB swept_aabb( Collider &c, vec3 motion ) {
+    AABB box = collider_aabb(c);
+    return merge(box, { box.m_min + motion, box.m_max + motion });
+}
+
+//call on_hit(CastHit) for every collider of the broad phase that coll hits while moving by motion
+//collider_of(item) returns the collider of a broad phase item, or nullptr to skip it
+//returns the number of hits, they are not ordered by time
+template<typename BroadPhase, typename C, typename F>
+inline int shape_cast( const BroadPhase &broad_phase, uint32_t mask, Collider &coll, vec3 motion, C&& collider_of, F&& on_hit ) {
+    int hits = 0;
+    broad_phase.query(swept_aabb(coll, motion), mask, [&]( int item ) {
+        Collider *other = collider_of(item);
+        CastHit hit;
+        if (other != nullptr && time_of_impact(coll, motion, *other, hit.m_toi, hit.m_normal)) {
+            hit.m_item = item;
+            on_hit(hit);
+            hits++;
+        }
+        return true;
+    });
+    return hits;
+}
+
+//the first collider coll hits while moving by motion, false if there is none
+template<typename BroadPhase, typename C>
+inline bool shape_cast_first( const BroadPhase &broad_phase, uint32_t mask, Collider &coll, vec3 motion, C&& collider_of, CastHit &first ) {
+    first = CastHit();
+    shape_cast(broad_phase, mask, coll, motion, collider_of, [&]( const CastHit &hit ) {
+        if (first.m_item < 0 || hit.m_toi < first.m_toi) first = hit;
+    });
+    return first.m_item >= 0;
+}
+
+//the first collider hit by the segment from - to, m_toi is the fraction of the way
+template<typename BroadPhase, typename C>
+inline bool ray_cast( const BroadPhase &broad_phase, uint32_t mask, vec3 from, vec3 to, C&& collider_of, CastHit &first ) {
+    Point point(from);
+    return shape_cast_first(broad_phase, mask, point, to - from, collider_of, first);
+}
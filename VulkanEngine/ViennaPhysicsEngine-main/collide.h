@@ -0,0 +1,165 @@
+#pragma once
+
+#include <cmath>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/ext.hpp>
+
+#include "collider.h"
+#include "gjk_epa.h"
+#include "broadphase.h"
+
+//Boolean collision test with a kernel per pair of shapes.
+//collide(a, b) only answers whether two colliders intersect, so unlike gjk(a, b, mtv, p, true)
+//it never runs EPA. It looks up a kernel by the m_shape of both colliders:
+//  sphere - sphere     distance of the centers
+//  sphere - box        distance from the center to the closest point of the oriented box
+//  box - box           interval test if both boxes are axis aligned, else the 15 axis SAT
+//                      for oriented boxes (Ericson, Real-Time Collision Detection, 4.4.1)
+//  anything else       gjk without EPA, through the support functions
+//Boxes whose m_matRS shears them are no oriented boxes and also take gjk.
+//Touching colliders count as intersecting.
+
+
+//a box as center, orthonormal axes and half extents along them
+struct OrientedBox {
+    vec3 m_center;
+    vec3 m_axis[3];
+    float m_half[3];
+};
+
+//model space corners of a Box or BBox
+inline void box_corners( Collider &c, vec3 &lo, vec3 &hi ) {
+    if (c.m_shape == SHAPE_BBOX) {
+        lo = static_cast<BBox&>(c).m_min;
+        hi = static_cast<BBox&>(c).m_max;
+    } else {
+        lo = vec3(-0.5f);
+        hi = vec3(0.5f);
+    }
+}
+
+//true if m_matRS only scales, then the box is an AABB in world space
+inline bool axis_aligned( const Collider &c ) {
+    const mat3 &m = c.m_matRS;
+    return m[0].y == 0.0f && m[0].z == 0.0f && m[1].x == 0.0f && m[1].z == 0.0f && m[2].x == 0.0f && m[2].y == 0.0f;
+}
+
+//world space bounds of an axis aligned Box or BBox, without calling its support function
+inline AABB aligned_box_aabb( Collider &c ) {
+    vec3 lo, hi;
+    box_corners(c, lo, hi);
+    vec3 scale_diag(c.m_matRS[0].x, c.m_matRS[1].y, c.m_matRS[2].z);
+    vec3 center = scale_diag * ((lo + hi) * 0.5f) + c.m_pos;
+    vec3 half = abs(scale_diag * (hi - lo) * 0.5f);
+    return { center - half, center + half };
+}
+
+//false if m_matRS shears the box
+inline bool oriented_box( Collider &c, OrientedBox &box ) {
+    vec3 lo, hi;
+    box_corners(c, lo, hi);
+    box.m_center = c.m_matRS * ((lo + hi) * 0.5f) + c.m_pos;
+    vec3 half = (hi - lo) * 0.5f;
+    for (int i = 0; i < 3; i++) {
+        float len = length(c.m_matRS[i]);
+        if (len < EPS) return false;
+        box.m_axis[i] = c.m_matRS[i] / len;
+        box.m_half[i] = half[i] * len;
+    }
+    for (int i = 0; i < 3; i++) {
+        if (std::abs(dot(box.m_axis[i], box.m_axis[(i + 1) % 3])) > 1.0e-4f) return false;
+    }
+    return true;
+}
+
+//separating axis test of two oriented boxes, the 3 + 3 face normals and the 9 edge cross products
+inline bool obb_overlap( const OrientedBox &a, const OrientedBox &b ) {
+    float R[3][3], absR[3][3];
+    for (int i = 0; i < 3; i++) {
+        for (int j = 0; j < 3; j++) {
+            R[i][j] = dot(a.m_axis[i], b.m_axis[j]);
+            absR[i][j] = std::abs(R[i][j]) + EPS;   //parallel edges have a null cross product
+        }
+    }
+    vec3 d = b.m_center - a.m_center;
+    float t[3] = { dot(d, a.m_axis[0]), dot(d, a.m_axis[1]), dot(d, a.m_axis[2]) };   //in the frame of a
+    const float *ea = a.m_half, *eb = b.m_half;
+
+    for (int i = 0; i < 3; i++) {
+        float rb = eb[0] * absR[i][0] + eb[1] * absR[i][1] + eb[2] * absR[i][2];
+        if (std::abs(t[i]) > ea[i] + rb) return false;
+    }
+    for (int j = 0; j < 3; j++) {
+        float ra = ea[0] * absR[0][j] + ea[1] * absR[1][j] + ea[2] * absR[2][j];
+        if (std::abs(t[0] * R[0][j] + t[1] * R[1][j] + t[2] * R[2][j]) > ra + eb[j]) return false;
+    }
+    for (int i = 0; i < 3; i++) {
+        int i1 = (i + 1) % 3, i2 = (i + 2) % 3;
+        for (int j = 0; j < 3; j++) {
+            int j1 = (j + 1) % 3, j2 = (j + 2) % 3;
+            float ra = ea[i1] * absR[i2][j] + ea[i2] * absR[i1][j];
+            float rb = eb[j1] * absR[i][j2] + eb[j2] * absR[i][j1];
+            if (std::abs(t[i2] * R[i1][j] - t[i1] * R[i2][j]) > ra + rb) return false;
+        }
+    }
+    return true;
+}
+
+
+//kernels, the shapes of the arguments are known from the table
+
+using CollisionKernel = bool (*)( Collider &, Collider & );
+
+inline bool collide_convex( Collider &a, Collider &b ) {
+    return gjk(a, b);
+}
+
+inline bool collide_sphere_sphere( Collider &a, Collider &b ) {
+    Sphere &sa = static_cast<Sphere&>(a), &sb = static_cast<Sphere&>(b);
+    vec3 d = sb.m_pos - sa.m_pos;
+    float r = sa.m_r + sb.m_r;
+    return dot(d, d) <= r * r;
+}
+
+inline bool collide_sphere_box( Collider &a, Collider &b ) {
+    Sphere &s = static_cast<Sphere&>(a);
+    OrientedBox box;
+    if (!oriented_box(b, box)) return gjk(a, b);
+    vec3 d = s.m_pos - box.m_center;
+    float dist2 = 0.0f;
+    for (int i = 0; i < 3; i++) {
+        float outside = std::abs(dot(d, box.m_axis[i])) - box.m_half[i];
+        if (outside > 0.0f) dist2 += outside * outside;
+    }
+    return dist2 <= s.m_r * s.m_r;
+}
+
+inline bool collide_box_sphere( Collider &a, Collider &b ) {
+    return collide_sphere_box(b, a);
+}
+
+inline bool collide_box_box( Collider &a, Collider &b ) {
+    if (axis_aligned(a) && axis_aligned(b)) return aligned_box_aabb(a).overlaps(aligned_box_aabb(b));
+    OrientedBox oa, ob;
+    if (!oriented_box(a, oa) || !oriented_box(b, ob)) return gjk(a, b);
+    return obb_overlap(oa, ob);
+}
+
+//kernel for a pair of shapes
+inline CollisionKernel collision_kernel( ShapeType a, ShapeType b ) {
+    static const CollisionKernel table[SHAPE_COUNT][SHAPE_COUNT] = {
+        //              CONVEX          SPHERE                  BOX                     BBOX
+        /*CONVEX*/  {   collide_convex, collide_convex,         collide_convex,         collide_convex      },
+        /*SPHERE*/  {   collide_convex, collide_sphere_sphere,  collide_sphere_box,     collide_sphere_box  },
+        /*BOX*/     {   collide_convex, collide_box_sphere,     collide_box_box,        collide_box_box     },
+        /*BBOX*/    {   collide_convex, collide_box_sphere,     collide_box_box,        collide_box_box     },
+    };
+    return table[a][b];
+}
+
+//true if a and b intersect
+inline bool collide( Collider &a, Collider &b ) {
+    return collision_kernel(a.m_shape, b.m_shape)(a, b);
+}
@@ -10,6 +10,10 @@ constexpr float EPS = 1.0e-6f;
 struct ICollider {
     ICollider(){};
     virtual vec3 support(vec3 dir) = 0;
+
+    //support for queries that keep their own state: a hill climbing support function starts
+    //at vertex hint and leaves it at the result, other shapes ignore hint
+    virtual vec3 support_hinted(vec3 dir, int &/*hint*/) { return support(dir); }
 };
 
 
@@ -23,11 +27,23 @@ struct pluecker_line {          // 6D line coordinates { direction vector | p0 x
 };
 
 
+//Shape of a collider, picks the closed-form kernel in collide.h
+//Shapes without a kernel of their own are SHAPE_CONVEX and only have their support function
+enum ShapeType {
+    SHAPE_CONVEX = 0,
+    SHAPE_SPHERE,           //Sphere: m_pos and m_r
+    SHAPE_BOX,              //Box: the unit cube transformed by m_matRS
+    SHAPE_BBOX,             //BBox: m_min, m_max transformed by m_matRS
+    SHAPE_COUNT
+};
+
+
 //Base struct for all collision shapes
 struct Collider : ICollider {
     vec3    m_pos;            //origin in world space
     mat3    m_matRS;          //rotation/scale component of model matrix
     mat3    m_matRS_inverse; 
+    ShapeType m_shape = SHAPE_CONVEX;
 
     Collider( vec3 p = {0,0,0}, mat3 m = mat3(1.f) ) : ICollider() {
         m_pos = p;
@@ -40,6 +56,8 @@ struct Collider : ICollider {
 struct BBox : Collider {
     vec3 m_min, m_max; //Assume these are axis aligned!
 
+    BBox( vec3 pos = vec3(0.0f, 0.0f, 0.0f), mat3 matRS = mat3(1.0f) ) : Collider(pos, matRS) { m_shape = SHAPE_BBOX; }
+
     vec3 support(vec3 dir){
         dir = m_matRS_inverse*dir; //find support in model space
 
@@ -56,7 +74,7 @@ struct BBox : Collider {
 struct Sphere : Collider {
     float m_r;
 
-    Sphere( vec3 pos = vec3(0.0f, 0.0f, 0.0f), float radius = 1.0f) : Collider(pos, mat3(1.0f)), m_r(radius) {};
+    Sphere( vec3 pos = vec3(0.0f, 0.0f, 0.0f), float radius = 1.0f) : Collider(pos, mat3(1.0f)), m_r(radius) { m_shape = SHAPE_SPHERE; };
 
     vec3 support(vec3 dir){
         return normalize(dir)*m_r + m_pos;
@@ -260,12 +278,18 @@ struct Polytope : Collider {
     std::vector<vec3>     m_points;
     std::vector<Vertex>   m_vertices;
     std::vector<Face>     m_faces;
-    int                   support_point = -1;
+    int                   support_point = -1;   //vertex support(dir) starts at, never written by a query
 
     Polytope( vec3 pos = {0,0,0}, mat3 matRS = mat3(1.0f) ) : Collider(pos, matRS) {}
 
-    //Dumb O(n) support function, just brute force check all points
+    //does not change the polytope, so it may be queried from several threads at once
     vec3 support(vec3 dir) {
+        int hint = support_point;
+        return support_hinted(dir, hint);
+    }
+
+    //Dumb O(n) support function, just brute force check all points
+    vec3 support_hinted(vec3 dir, int &hint) {
         dir = m_matRS_inverse*dir;
 
         vec3 furthest_point; 
@@ -284,17 +308,17 @@ struct Polytope : Collider {
                             } );
         } else {
             //ADD YOUR CODE HERE TO ITERATE THROUGH NEIGHBORS rather than iterate through all points
-            if (support_point < 0) {
-                support_point = 0;
+            if (hint < 0 || hint >= (int)m_points.size()) {
+                hint = 0;
             }
 
-            furthest_point = m_points[support_point]; 
+            furthest_point = m_points[hint]; 
             max_dot = dot(furthest_point, dir);
-            int max = support_point;
+            int max = hint;
 
             do {
-                support_point = max;
-                for ( int neighbor : m_vertices[support_point].neighbors() ) {
+                hint = max;
+                for ( int neighbor : m_vertices[hint].neighbors() ) {
                     float d = dot(m_points[neighbor], dir);
                     if (d > max_dot) {
                         max_dot = d;
@@ -302,7 +326,7 @@ struct Polytope : Collider {
                         max = neighbor;
                     }
                 }
-            } while( max != support_point );
+            } while( max != hint );
         }
 
         vec3 result = m_matRS*furthest_point + m_pos; //convert support to world space
@@ -382,6 +406,7 @@ struct Box : Polytope {
 
         for( const auto& data : m_vertices_data ) m_vertices.emplace_back(  this, &data );
         for( const auto& data : m_faces_data ) m_faces.emplace_back( this, &data );
+        m_shape = SHAPE_BOX;
     };
 };
 
@@ -393,6 +418,7 @@ struct Quad3D : Box {
         vec3 d1 = p1 - p0;
         vec3 up = EPS * normalize( cross( d0,  d1) );
 	    m_points = { p0, p1, p2, p3, p0 + up, p1 + up, p2 + up, p3 + up };
+        m_shape = SHAPE_CONVEX;    //no longer the unit cube
     };
 };
 
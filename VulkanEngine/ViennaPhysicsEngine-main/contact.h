@@ -12,6 +12,7 @@
 #include "hash.h"
 #include <random>
 #include <set>
+#include <vector>
 
 #include "collider.h"
 #include "sat.h"
@@ -94,7 +95,7 @@ void process_face_face_contact(    Polytope &obj1, Polytope &obj2, vec3 &dir
                                 ,  int f1, int f2, std::set<contact> & contacts ) {
     
     Face &face1 = obj1.m_faces[f1];
-    Face &face2 = obj1.m_faces[f2];
+    Face &face2 = obj2.m_faces[f2];
     for( int v1 : face1.m_data->m_vertices ) {      //go through all vertices of face 1
         if( sat( obj1.m_vertices[v1], face2, dir) ) {
             process_vertex_face_contact( face1.m_polytope->m_vertices[v1], face2, contacts );
@@ -170,6 +171,14 @@ void  contacts( Polytope &obj1, Polytope &obj2, vec3 &dir, std::set<contact> & c
     neighboring_faces( obj1, obj2, dir, contacts);
 }
 
+//append the contact points between two objects to an array, in the order of the set
+//each thread of a parallel narrow phase collects the contacts of its pairs in its own array
+void  contacts( Polytope &obj1, Polytope &obj2, vec3 &dir, std::vector<contact> & out ) {
+    std::set<contact> found;
+    contacts( obj1, obj2, dir, found );
+    out.insert( out.end(), found.begin(), found.end() );
+}
+
 
 };
 
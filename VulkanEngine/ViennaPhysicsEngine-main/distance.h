@@ -1,3 +1,153 @@
 #pragma once
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
 
+#include <glm/glm.hpp>
+#include <glm/ext.hpp>
+
+#include "collider.h"
+
+//Distance of two convex colliders with GJK (Gilbert, Johnson, Keerthi 1988, in the form of
+//van den Bergen, Collision Detection in Interactive 3D Environments, 4.3).
+//GJK walks a simplex of points of the Minkowski difference coll2 - coll1 toward the origin.
+//Every iteration finds the point of the simplex closest to the origin (Ericson, Real-Time Collision
+//Detection, 5.1), drops the vertices it does not need and adds the support point in the direction
+//of the origin, until no support point gets closer. The closest point of the difference is the
+//vector between the closest points of the colliders, its length is their distance.
+//Re-entrant like gjk(): the support hints live in the query.
+
+
+constexpr int   GJK_DISTANCE_MAX_ITERATIONS = 32;
+constexpr float GJK_DISTANCE_TOLERANCE = 1.0e-5f;      //relative progress that ends the iteration
+
+//up to four points of the Minkowski difference
+struct DistanceSimplex {
+    vec3 m_p[4];
+    int  m_n = 0;
+
+    //keep the vertices whose bits are set in mask
+    void reduce( int mask ) {
+        int n = 0;
+        for (int i = 0; i < m_n; i++) {
+            if (mask & (1 << i)) m_p[n++] = m_p[i];
+        }
+        m_n = n;
+    }
+};
+
+//closest point of segment ab to the origin, mask gets the vertices it needs
+inline vec3 closest_on_segment( vec3 a, vec3 b, int &mask ) {
+    vec3 ab = b - a;
+    float len2 = dot(ab, ab);
+    float t = len2 > 0.0f ? -dot(a, ab) / len2 : 0.0f;
+    if (t <= 0.0f) { mask = 1; return a; }
+    if (t >= 1.0f) { mask = 2; return b; }
+    mask = 3;
+    return a + ab * t;
+}
+
+//closest point of triangle abc to the origin, Ericson 5.1.5, mask gets the vertices it needs
+inline vec3 closest_on_triangle( vec3 a, vec3 b, vec3 c, int &mask ) {
+    vec3 ab = b - a, ac = c - a;
+    float d1 = dot(ab, -a), d2 = dot(ac, -a);
+    if (d1 <= 0.0f && d2 <= 0.0f) { mask = 1; return a; }
+
+    float d3 = dot(ab, -b), d4 = dot(ac, -b);
+    if (d3 >= 0.0f && d4 <= d3) { mask = 2; return b; }
+
+    float vc = d1 * d4 - d3 * d2;
+    if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f) { mask = 3; return a + ab * (d1 / (d1 - d3)); }
+
+    float d5 = dot(ab, -c), d6 = dot(ac, -c);
+    if (d6 >= 0.0f && d5 <= d6) { mask = 4; return c; }
+
+    float vb = d5 * d2 - d1 * d6;
+    if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f) { mask = 5; return a + ac * (d2 / (d2 - d6)); }
+
+    float va = d3 * d6 - d5 * d4;
+    if (va <= 0.0f && d4 - d3 >= 0.0f && d5 - d6 >= 0.0f) { mask = 6; return b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6))); }
+
+    float denom = va + vb + vc;
+    if (denom == 0.0f) return closest_on_segment(a, b, mask);      //degenerate triangle
+    mask = 7;
+    return a + ab * (vb / denom) + ac * (vc / denom);
+}
+
+//closest point of tetrahedron abcd to the origin, Ericson 5.1.6, the origin itself if it is inside
+inline vec3 closest_on_tetrahedron( const vec3 p[4], int &mask ) {
+    static const int faces[4][4] = { { 0, 1, 2, 3 }, { 0, 2, 3, 1 }, { 0, 3, 1, 2 }, { 1, 3, 2, 0 } };  //face and opposite vertex
+    vec3 best(0.0f);
+    float best_dist = std::numeric_limits<float>::max();
+    mask = 15;
+    for (auto &f : faces) {
+        vec3 a = p[f[0]], b = p[f[1]], c = p[f[2]];
+        vec3 n = cross(b - a, c - a);
+        float origin_side = dot(-a, n), opposite_side = dot(p[f[3]] - a, n);
+        if (origin_side * opposite_side >= 0.0f && opposite_side != 0.0f) continue;   //origin on the inner side of this face
+        int face_mask;
+        vec3 q = closest_on_triangle(a, b, c, face_mask);
+        float dist = dot(q, q);
+        if (dist < best_dist) {
+            best_dist = dist;
+            best = q;
+            mask = 0;
+            for (int k = 0; k < 3; k++) {
+                if (face_mask & (1 << k)) mask |= 1 << f[k];
+            }
+        }
+    }
+    return best;
+}
+
+//closest point of the simplex to the origin, reduces the simplex to the vertices it needs
+inline vec3 closest_on_simplex( DistanceSimplex &s ) {
+    int mask = 1;
+    vec3 v = s.m_p[0];
+    if (s.m_n == 2) v = closest_on_segment(s.m_p[0], s.m_p[1], mask);
+    else if (s.m_n == 3) v = closest_on_triangle(s.m_p[0], s.m_p[1], s.m_p[2], mask);
+    else if (s.m_n == 4) v = closest_on_tetrahedron(s.m_p, mask);
+    s.reduce(mask);
+    return v;
+}
+
+//distance of coll1 and coll2 after moving coll2 by offset relative to coll1, 0 if they intersect
+//closest is the point of the Minkowski difference closest to the origin: the vector from the
+//closest point of coll1 to the closest point of coll2
+inline float gjk_distance( Collider &coll1, Collider &coll2, vec3 offset, vec3 &closest ) {
+    int hint[2] = { -1, -1 };
+    auto support = [&]( vec3 dir ) {
+        return coll2.support_hinted(dir, hint[1]) - coll1.support_hinted(-dir, hint[0]) + offset;
+    };
+
+    DistanceSimplex s;
+    vec3 v = coll2.m_pos - coll1.m_pos + offset;
+    if (dot(v, v) == 0.0f) v = vec3(1.0f, 0.0f, 0.0f);
+    s.m_p[s.m_n++] = support(-v);
+    v = s.m_p[0];
+
+    for (int iterations = 0; iterations < GJK_DISTANCE_MAX_ITERATIONS; iterations++) {
+        float v2 = dot(v, v);
+        if (v2 <= EPS * EPS) break;                                     //origin on the simplex
+        vec3 w = support(-v);
+        if (v2 - dot(v, w) <= GJK_DISTANCE_TOLERANCE * v2) break;       //w is not closer than v
+        bool known = false;
+        for (int i = 0; i < s.m_n; i++) known = known || s.m_p[i] == w;
+        if (known) break;
+        s.m_p[s.m_n++] = w;
+        v = closest_on_simplex(s);
+        if (s.m_n == 4) {                                               //origin inside the tetrahedron
+            v = vec3(0.0f);
+            break;
+        }
+    }
+    closest = v;
+    return length(v);
+}
+
+inline float gjk_distance( Collider &coll1, Collider &coll2 ) {
+    vec3 closest;
+    return gjk_distance(coll1, coll2, vec3(0.0f), closest);
+}
@@ -29,6 +29,7 @@
 
 //Returns true if two colliders are intersecting. Has optional Minimum Translation Vector output param;
 //If supplied the EPA will be used to find the vector to separate coll1 from coll2
+//Re-entrant: the support hints of a query live on its stack, the colliders are not changed
 bool gjk(Collider& coll1, Collider& coll2, vec3& mtv, vec3& point, bool epa = true);
 bool gjk(Collider& coll1, Collider& coll2 );
 
@@ -37,7 +38,8 @@ void update_simplex3(vec3 &a, vec3 &b, vec3 &c, vec3 &d, int &simp_dim, vec3 &se
 bool update_simplex4(vec3 &a, vec3 &b, vec3 &c, vec3 &d, int &simp_dim, vec3 &search_dir);
 //Expanding Polytope Algorithm. Used to find the mtv of two intersecting 
 //colliders using the final simplex obtained with the GJK algorithm
-vec3 EPA(vec3 a, vec3 b, vec3 c, vec3 d, Collider& coll1, Collider& coll2);
+//hint holds the support hints of coll1 and coll2, see ICollider::support
+vec3 EPA(vec3 a, vec3 b, vec3 c, vec3 d, Collider& coll1, Collider& coll2, int hint[2]);
 
 #define GJK_MAX_NUM_ITERATIONS 64
 
@@ -50,13 +52,14 @@ bool gjk(Collider& coll1, Collider& coll2 ) {
 bool gjk(Collider& coll1, Collider& coll2, vec3& mtv, vec3& point, bool epa) {
     vec3 a, b, c, d; //Simplex: just a set of points (a is always most recently added)
     vec3 search_dir = coll1.m_pos - coll2.m_pos; //initial search direction between colliders
+    int hint[2] = { -1, -1 }; //where the support functions of coll1 and coll2 start climbing
 
     //Get initial point for simplex
-    c = coll2.support(search_dir) - coll1.support(-search_dir);
+    c = coll2.support_hinted(search_dir, hint[1]) - coll1.support_hinted(-search_dir, hint[0]);
     search_dir = -c; //search in direction of origin
 
     //Get second point for a line segment simplex
-    b = coll2.support(search_dir) - coll1.support(-search_dir);
+    b = coll2.support_hinted(search_dir, hint[1]) - coll1.support_hinted(-search_dir, hint[0]);
 
     if(dot(b, search_dir)<0) { return false; }//we didn't reach the origin, won't enclose it
 
@@ -70,7 +73,7 @@ bool gjk(Collider& coll1, Collider& coll2, vec3& mtv, vec3& point, bool epa) {
     
     for(int iterations=0; iterations<GJK_MAX_NUM_ITERATIONS; iterations++)
     {
-        a = coll2.support(search_dir) - coll1.support(-search_dir);
+        a = coll2.support_hinted(search_dir, hint[1]) - coll1.support_hinted(-search_dir, hint[0]);
         if(dot(a, search_dir)<0) { return false; }//we didn't reach the origin, won't enclose it
     
         simp_dim++;
@@ -78,7 +81,7 @@ bool gjk(Collider& coll1, Collider& coll2, vec3& mtv, vec3& point, bool epa) {
             update_simplex3(a,b,c,d,simp_dim,search_dir);
         }
         else if(update_simplex4(a,b,c,d,simp_dim,search_dir)) {
-            if(epa) mtv = EPA(a,b,c,d,coll1,coll2);
+            if(epa) mtv = EPA(a,b,c,d,coll1,coll2,hint);
             point = a;
             return true;
         }
@@ -188,7 +191,7 @@ bool update_simplex4(vec3 &a, vec3 &b, vec3 &c, vec3 &d, int &simp_dim, vec3 &se
 #define EPA_MAX_NUM_FACES 64
 #define EPA_MAX_NUM_LOOSE_EDGES 32
 #define EPA_MAX_NUM_ITERATIONS 64
-vec3 EPA(vec3 a, vec3 b, vec3 c, vec3 d, Collider& coll1, Collider& coll2){
+vec3 EPA(vec3 a, vec3 b, vec3 c, vec3 d, Collider& coll1, Collider& coll2, int hint[2]){
     vec3 faces[EPA_MAX_NUM_FACES][4]; //Array of faces, each with 3 verts and a normal
     
     //Init with final simplex from GJK
@@ -226,7 +229,7 @@ vec3 EPA(vec3 a, vec3 b, vec3 c, vec3 d, Collider& coll1, Collider& coll2){
 
         //search normal to face that's closest to origin
         vec3 search_dir = faces[closest_face][3]; 
-        vec3 p = coll2.support(search_dir) - coll1.support(-search_dir);
+        vec3 p = coll2.support_hinted(search_dir, hint[1]) - coll1.support_hinted(-search_dir, hint[0]);
 
         if(dot(p, search_dir)-min_dist<EPA_TOLERANCE){
             //Convergence (new point is not significantly further from origin)
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <algorithm>
+#include <future>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/ext.hpp>
+
+#include <ThreadPool.h>
+
+#include "collider.h"
+#include "contact.h"
+#include "collide.h"
+#include "pair_cache.h"
+
+//Parallel narrow phase over the candidate pairs of a broad phase.
+//The narrow phase functions are re-entrant: gjk, EPA, sat and contacts keep their mutable state
+//on the stack of the query, gjk_cached in the PairCacheEntry of its pair, none of them writes to
+//a collider or to a static. So pairs that share a collider may be tested on different threads.
+//
+//NarrowPhase<T>::run(n, test, pool) calls test(pair, out) for the pairs 0 .. n-1. The pairs are cut
+//into contiguous ranges, each range is a ThreadPool job with its own result array, so the jobs
+//share nothing. Afterwards the arrays are concatenated in range order: the results come out
+//ordered by pair, exactly as a serial loop would produce them, for any number of threads.
+//The arrays are kept between runs, so a narrow phase that runs every frame does not allocate.
+
+
+constexpr int NARROW_PHASE_CHUNK = 32;      //fewest pairs per parallel job
+constexpr int NARROW_PHASE_JOBS = 4;        //jobs per thread, more jobs balance uneven pairs better
+
+//a candidate pair of colliders
+struct CollisionPair {
+    Collider *m_a;
+    Collider *m_b;
+};
+
+//the contact points of the pair m_pair of a run, as found by contacts() of contact.h
+struct PairContact {
+    int m_pair;
+    vpe::contact m_contact;
+};
+
+
+template<typename T>
+class NarrowPhase {
+public:
+    //test(pair, out) tests one pair and appends what it found to out, it must be safe to call
+    //from several threads for different pairs. Returns the results of all pairs, ordered by pair.
+    template<typename F>
+    const std::vector<T> &run( int num_pairs, F&& test, ThreadPool *pool = nullptr ) {
+        int jobs = 1;
+        if (pool != nullptr && num_pairs >= 2 * NARROW_PHASE_CHUNK) {
+            jobs = std::max(1, std::min((int)pool->threadCount() * NARROW_PHASE_JOBS, num_pairs / NARROW_PHASE_CHUNK));
+        }
+        if ((int)m_buffers.size() < jobs) m_buffers.resize(jobs);
+
+        auto job = [&]( int j ) {
+            std::vector<T> &out = m_buffers[j];
+            out.clear();
+            for (int i = num_pairs * j / jobs; i < num_pairs * (j + 1) / jobs; i++) test(i, out);
+        };
+        if (jobs == 1) {
+            job(0);
+        } else {
+            std::vector<std::future<void>> futures;
+            for (int j = 0; j < jobs; j++) futures.push_back(pool->add(job, j));
+            for (auto &f : futures) f.get();
+        }
+
+        m_results.clear();
+        for (int j = 0; j < jobs; j++) m_results.insert(m_results.end(), m_buffers[j].begin(), m_buffers[j].end());
+        return m_results;
+    }
+
+    const std::vector<T> &results() const { return m_results; }
+
+private:
+    std::vector<std::vector<T>> m_buffers;  //one per job
+    std::vector<T> m_results;
+};
+
+
+//indices of the pairs whose colliders intersect, with collide() of collide.h
+inline const std::vector<int> &collide_pairs( NarrowPhase<int> &narrow, const std::vector<CollisionPair> &pairs, ThreadPool *pool = nullptr ) {
+    return narrow.run((int)pairs.size(), [&]( int i, std::vector<int> &out ) {
+        if (collide(*pairs[i].m_a, *pairs[i].m_b)) out.push_back(i);
+    }, pool);
+}
+
+//collide_pairs with warm started gjk, entries[i] is the PairCacheEntry of pairs[i]
+//fetch the entries with PairCache::get before, it is not thread safe
+inline const std::vector<int> &collide_pairs( NarrowPhase<int> &narrow, const std::vector<CollisionPair> &pairs
+                                            , const std::vector<PairCacheEntry*> &entries, ThreadPool *pool = nullptr ) {
+    return narrow.run((int)pairs.size(), [&]( int i, std::vector<int> &out ) {
+        Collider &a = *pairs[i].m_a, &b = *pairs[i].m_b;
+        CollisionKernel kernel = collision_kernel(a.m_shape, b.m_shape);
+        if (kernel != collide_convex ? kernel(a, b) : gjk_cached(a, b, *entries[i])) out.push_back(i);
+    }, pool);
+}
+
+//contact points of pairs of polytopes, with contacts() of contact.h
+inline const std::vector<PairContact> &contact_pairs( NarrowPhase<PairContact> &narrow, const std::vector<std::pair<Polytope*, Polytope*>> &pairs
+                                                    , ThreadPool *pool = nullptr ) {
+    return narrow.run((int)pairs.size(), [&]( int i, std::vector<PairContact> &out ) {
+        std::vector<vpe::contact> found;
+        vec3 dir(0.0f);
+        vpe::contacts(*pairs[i].first, *pairs[i].second, dir, found);
+        for (auto &c : found) out.push_back({ i, c });
+    }, pool);
+}
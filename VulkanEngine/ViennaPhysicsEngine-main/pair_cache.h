@@ -0,0 +1,249 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/ext.hpp>
+
+#include "collider.h"
+#include "gjk_epa.h"
+#include "sat.h"
+#include "collide.h"
+
+//Warm starting of GJK and SAT for pairs of colliders that are tested every frame.
+//Colliders move little from one frame to the next, so the result of the last test is a good
+//guess for the next one. A PairCacheEntry keeps, per pair:
+//  - the last separating axis: if it still separates, one support point of the Minkowski
+//    difference proves it and the test ends after a single iteration
+//  - the support directions of the last simplex that enclosed the origin: the four support
+//    points along them are recomputed, if they still enclose the origin the pair intersects
+//  - the vertex each polytope's hill climbing support function ended on for this pair
+//If neither shortcut holds, gjk_cached runs GJK starting from the cached axis and refreshes
+//the entry. The answers are the same as gjk(a, b), only the work differs.
+//gjk_cached only writes to the entry, never to the colliders, so different pairs may be
+//tested on different threads even if they share a collider.
+//
+//PairCache owns the entries by collider address. Call begin_frame() once per frame; entries
+//not used for max_age frames are dropped, so pairs that stopped being tested do not pile up.
+//get() and begin_frame() change the map and are not thread safe, fetch the entries first.
+
+
+struct PairCacheEntry {
+    vec3 m_axis{ 0.0f };            //last separating direction of the Minkowski difference, zero if none
+    vec3 m_simplex[4];              //support directions of the last enclosing simplex
+    int m_simplex_dim = 0;          //4 if m_simplex is valid
+    int m_support[2] = { -1, -1 };  //support hints of the two colliders after the last test
+    uint32_t m_frame = 0;           //frame the entry was last used
+    int m_iterations = 0;           //GJK iterations of the last test, 1 if a cached result held
+};
+
+
+//a point of the Minkowski difference coll2 - coll1 and the direction it was found with
+struct GjkVertex {
+    vec3 m_p;
+    vec3 m_dir;
+};
+
+inline GjkVertex gjk_vertex( Collider &coll1, Collider &coll2, vec3 dir, int hint[2] ) {
+    return { coll2.support_hinted(dir, hint[1]) - coll1.support_hinted(-dir, hint[0]), dir };
+}
+
+//update_simplex3 of gjk_epa.h, moving the support directions along with the points
+inline void update_simplex3( GjkVertex &a, GjkVertex &b, GjkVertex &c, GjkVertex &d, int &simp_dim, vec3 &search_dir ) {
+    vec3 n = cross(b.m_p - a.m_p, c.m_p - a.m_p);
+    vec3 AO = -a.m_p;
+
+    simp_dim = 2;
+    if (dot(cross(b.m_p - a.m_p, n), AO) > 0) {    //closest to edge AB
+        c = a;
+        search_dir = cross(cross(b.m_p - a.m_p, AO), b.m_p - a.m_p);
+        return;
+    }
+    if (dot(cross(n, c.m_p - a.m_p), AO) > 0) {    //closest to edge AC
+        b = a;
+        search_dir = cross(cross(c.m_p - a.m_p, AO), c.m_p - a.m_p);
+        return;
+    }
+
+    simp_dim = 3;
+    if (dot(n, AO) > 0) {   //above triangle
+        d = c;
+        c = b;
+        b = a;
+        search_dir = n;
+        return;
+    }
+    d = b;                  //below triangle
+    b = a;
+    search_dir = -n;
+}
+
+//update_simplex4 of gjk_epa.h, moving the support directions along with the points
+inline bool update_simplex4( GjkVertex &a, GjkVertex &b, GjkVertex &c, GjkVertex &d, int &simp_dim, vec3 &search_dir ) {
+    vec3 ABC = cross(b.m_p - a.m_p, c.m_p - a.m_p);
+    vec3 ACD = cross(c.m_p - a.m_p, d.m_p - a.m_p);
+    vec3 ADB = cross(d.m_p - a.m_p, b.m_p - a.m_p);
+
+    vec3 AO = -a.m_p;
+    simp_dim = 3;
+
+    if (dot(ABC, AO) > 0) {     //in front of ABC
+        d = c;
+        c = b;
+        b = a;
+        search_dir = ABC;
+        return false;
+    }
+    if (dot(ACD, AO) > 0) {     //in front of ACD
+        b = a;
+        search_dir = ACD;
+        return false;
+    }
+    if (dot(ADB, AO) > 0) {     //in front of ADB
+        c = d;
+        d = b;
+        b = a;
+        search_dir = ADB;
+        return false;
+    }
+    return true;
+}
+
+//true if the origin lies in the tetrahedron, false also if it is flat
+inline bool tetrahedron_contains_origin( const GjkVertex v[4] ) {
+    static const int faces[4][4] = { { 0, 1, 2, 3 }, { 0, 1, 3, 2 }, { 0, 2, 3, 1 }, { 1, 2, 3, 0 } };  //face and opposite vertex
+    for (auto &f : faces) {
+        vec3 p0 = v[f[0]].m_p;
+        vec3 n = cross(v[f[1]].m_p - p0, v[f[2]].m_p - p0);
+        float opposite = dot(n, v[f[3]].m_p - p0);
+        if (opposite == 0.0f || opposite * dot(n, -p0) < 0.0f) return false;
+    }
+    return true;
+}
+
+
+
+//GJK intersection test (no EPA) that starts from and updates cache
+inline bool gjk_cached( Collider &coll1, Collider &coll2, PairCacheEntry &cache ) {
+    int *hint = cache.m_support;        //the support functions climb on from where they ended last time
+    cache.m_iterations = 1;
+
+    auto separated = [&]( vec3 axis ) {
+        cache.m_axis = axis;
+        cache.m_simplex_dim = 0;
+        return false;
+    };
+    auto enclosed = [&]( const GjkVertex &a, const GjkVertex &b, const GjkVertex &c, const GjkVertex &d ) {
+        cache.m_simplex[0] = a.m_dir;
+        cache.m_simplex[1] = b.m_dir;
+        cache.m_simplex[2] = c.m_dir;
+        cache.m_simplex[3] = d.m_dir;
+        cache.m_simplex_dim = 4;
+        return true;
+    };
+
+    //the last enclosing simplex, moved along with the colliders
+    if (cache.m_simplex_dim == 4) {
+        GjkVertex v[4];
+        for (int k = 0; k < 4; k++) v[k] = gjk_vertex(coll1, coll2, cache.m_simplex[k], hint);
+        if (tetrahedron_contains_origin(v)) return enclosed(v[0], v[1], v[2], v[3]);
+    }
+
+    //gjk() of gjk_epa.h, except that it starts along the cached axis, where a
+    //support point behind the origin proves the pair separated right away
+    vec3 search_dir = dot(cache.m_axis, cache.m_axis) > 0.0f ? cache.m_axis : coll1.m_pos - coll2.m_pos;
+    if (search_dir == vec3(0, 0, 0)) search_dir = vec3(1, 0, 0);
+    GjkVertex a, b, c, d;
+    c = gjk_vertex(coll1, coll2, search_dir, hint);
+    if (dot(c.m_p, search_dir) < 0) return separated(search_dir);
+    search_dir = -c.m_p;
+
+    cache.m_iterations++;
+    b = gjk_vertex(coll1, coll2, search_dir, hint);
+    if (dot(b.m_p, search_dir) < 0) return separated(search_dir);
+
+    search_dir = cross(cross(c.m_p - b.m_p, -b.m_p), c.m_p - b.m_p);
+    if (search_dir == vec3(0, 0, 0)) {
+        search_dir = cross(c.m_p - b.m_p, vec3(1, 0, 0));
+        if (search_dir == vec3(0, 0, 0)) search_dir = cross(c.m_p - b.m_p, vec3(0, 0, -1));
+    }
+    int simp_dim = 2;
+
+    for (int iterations = 0; iterations < GJK_MAX_NUM_ITERATIONS; iterations++) {
+        cache.m_iterations++;
+        a = gjk_vertex(coll1, coll2, search_dir, hint);
+        if (dot(a.m_p, search_dir) < 0) return separated(search_dir);
+
+        simp_dim++;
+        if (simp_dim == 3) {
+            update_simplex3(a, b, c, d, simp_dim, search_dir);
+        } else if (update_simplex4(a, b, c, d, simp_dim, search_dir)) {
+            return enclosed(a, b, c, d);
+        }
+    }
+    cache.m_simplex_dim = 0;
+    return false;
+}
+
+//SAT test that first tries the cached separating axis, then the sat() of sat.h seeded with it
+//the axis is the one sat_axis_test takes, pointing from obj1 toward obj2
+template<typename T>
+inline bool sat_cached( T &obj1, T &obj2, PairCacheEntry &cache ) {
+    vec3 dir = cache.m_axis;
+    cache.m_iterations = 1;
+    if (dot(dir, dir) > 0.0f && sat_axis_test(obj1, obj2, dir)) return false;
+    cache.m_iterations = 2;
+    bool hit = sat(obj1, obj2, dir);
+    cache.m_axis = hit ? vec3(0.0f) : dir;
+    return hit;
+}
+
+
+class PairCache {
+public:
+    explicit PairCache( uint32_t max_age = 2 ) : m_max_age(max_age) {}
+
+    //the entry of the ordered pair (a, b), created empty on first use
+    PairCacheEntry &get( const Collider &a, const Collider &b ) {
+        PairCacheEntry &entry = m_entries[{ &a, &b }];
+        entry.m_frame = m_frame;
+        return entry;
+    }
+
+    //drop the pairs that were not tested during the last max_age frames
+    void begin_frame() {
+        m_frame++;
+        for (auto it = m_entries.begin(); it != m_entries.end(); ) {
+            if (m_frame - it->second.m_frame > m_max_age) it = m_entries.erase(it);
+            else ++it;
+        }
+    }
+
+    void clear() { m_entries.clear(); }
+    size_t size() const { return m_entries.size(); }
+
+private:
+    using Key = std::pair<const Collider*, const Collider*>;
+    struct KeyHash {
+        size_t operator()( const Key &k ) const {
+            size_t seed = std::hash<const Collider*>()(k.first);
+            return seed ^ (std::hash<const Collider*>()(k.second) + 0x9e3779b9 + (seed << 6) + (seed >> 2));
+        }
+    };
+
+    uint32_t m_max_age;
+    uint32_t m_frame = 0;
+    std::unordered_map<Key, PairCacheEntry, KeyHash> m_entries;
+};
+
+
+//collide() of collide.h, pairs without a closed form kernel run gjk_cached with their entry in cache
+inline bool collide( Collider &a, Collider &b, PairCache &cache ) {
+    CollisionKernel kernel = collision_kernel(a.m_shape, b.m_shape);
+    if (kernel != collide_convex) return kernel(a, b);
+    return gjk_cached(a, b, cache.get(a, b));
+}
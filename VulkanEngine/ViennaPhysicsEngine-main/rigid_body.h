@@ -0,0 +1,541 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <future>
+#include <limits>
+#include <unordered_map>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/ext.hpp>
+
+#include <ThreadPool.h>
+
+#include "collider.h"
+#include "gjk_epa.h"
+#include "contact.h"
+#include "broadphase.h"
+#include "narrow_phase.h"
+
+//Rigid body dynamics for polytope colliders.
+//A RigidBody moves the Polytope it was created with: after every step the world writes the
+//body's position and orientation into the collider's m_pos and m_matRS.
+//
+//RigidBodyWorld::step(dt, pool):
+//  - broad phase: the awake dynamic bodies query an AABBTree holding all bodies
+//  - narrow phase: gjk with EPA gives the normal and the depth of a pair, the vertices of either
+//    polytope that lie inside the other one become its contact points, stored as vpe::contact.
+//    The pairs are tested in parallel by a NarrowPhase, the results are merged in pair order.
+//    The exact feature search of contact.h (vpe::contacts) only reports features touching within
+//    EPS and finds nothing once the bodies interpenetrate, as they do between solver steps.
+//  - islands: dynamic bodies connected through contacts, found with union-find. Static bodies
+//    do not connect islands, so two stacks on the same floor are two islands.
+//  - every island is solved on its own: gravity and forces, a sequential impulse solver with
+//    Baumgarte stabilization and Coulomb friction, integration of positions and orientations.
+//    Islands share no dynamic body and no contact, so with a ThreadPool they run in parallel.
+//    They do share static bodies, so the solver only reads those: apply() skips the static side
+//    of a contact and a static body's velocity stays zero.
+//  - sleeping: an island whose bodies all stayed slower than the sleep thresholds for
+//    m_time_to_sleep seconds goes to sleep. Sleeping bodies are not queried, collided, solved
+//    or integrated until an awake body touches them or wake() is called.
+//Contacts keep their accumulated impulses from one step to the next by feature, the solver
+//starts from them (warm starting), so resting stacks converge in a few iterations.
+
+
+constexpr int RIGID_BODY_MAX_CONTACTS = 8;      //contact points per pair of bodies
+
+
+struct RigidBody {
+    Polytope *m_collider = nullptr;         //moved by the world
+    mat3  m_local{ 1.0f };                  //m_matRS of the collider when added, scale and initial orientation
+    vec3  m_pos{ 0.0f };                    //center of mass, the origin of the collider
+    mat3  m_rot{ 1.0f };                    //orientation relative to m_local
+    vec3  m_vel{ 0.0f };
+    vec3  m_ang_vel{ 0.0f };
+    vec3  m_force{ 0.0f };                  //applied during the next step, then cleared
+    vec3  m_torque{ 0.0f };
+    float m_inv_mass = 0.0f;                //0 for static bodies
+    vec3  m_inv_inertia_local{ 0.0f };      //diagonal of the inverse inertia tensor in body space
+    mat3  m_inv_inertia{ 0.0f };            //inverse inertia tensor in world space
+    float m_friction = 0.5f;
+    bool  m_awake = true;
+    float m_sleep_time = 0.0f;              //how long the body has been slow
+    int   m_proxy = BROADPHASE_NULL;
+
+    bool is_static() const { return m_inv_mass == 0.0f; }
+    bool active() const { return m_awake && !is_static(); }
+};
+
+//a contact point of a pair of bodies, pos and normal as in contact.h,
+//normal points from the second body of the pair to the first
+struct RigidContact {
+    vpe::contact m_contact;
+    int   m_feature;                        //vertex index, negated and minus 1 for vertices of the second body
+    float m_depth;
+    float m_normal_impulse = 0.0f;          //accumulated over the iterations, kept for warm starting
+    vec3  m_friction_impulse{ 0.0f };
+    vec3  m_ra, m_rb;                       //from the centers of mass to the point
+    vec3  m_tangent[2];
+    float m_normal_mass, m_tangent_mass[2];
+    float m_bias;
+};
+
+//all contact points between two bodies, m_a < m_b
+struct RigidManifold {
+    int m_a, m_b;
+    std::vector<RigidContact> m_points;
+    uint32_t m_step = 0;                    //step the points were last computed in
+};
+
+
+class RigidBodyWorld {
+public:
+    vec3  m_gravity{ 0.0f, -9.81f, 0.0f };
+    int   m_iterations = 10;                //velocity iterations per step
+    float m_baumgarte = 0.2f;               //fraction of the penetration removed per step
+    float m_slop = 0.01f;                   //penetration that is allowed to stay
+    float m_sleep_linear = 0.1f;            //sleep thresholds of the speeds
+    float m_sleep_angular = 0.1f;
+    float m_time_to_sleep = 0.5f;
+    float m_max_dt = 1.0f / 20.0f;          //longer steps are clamped
+
+    //a body that never moves
+    int add_static( Polytope &collider ) {
+        RigidBody body;
+        body.m_collider = &collider;
+        body.m_local = collider.m_matRS;
+        body.m_pos = collider.m_pos;
+        body.m_awake = false;
+        return add(body);
+    }
+
+    //a dynamic body, its inertia is the one of a solid box around the collider
+    //with lock_rotation the body only translates, like a character
+    int add_body( Polytope &collider, float mass, bool lock_rotation = false ) {
+        RigidBody body;
+        body.m_collider = &collider;
+        body.m_local = collider.m_matRS;
+        body.m_pos = collider.m_pos;
+        body.m_inv_mass = 1.0f / mass;
+        if (!lock_rotation) {
+            vec3 lo(std::numeric_limits<float>::max()), hi(-std::numeric_limits<float>::max());
+            for (auto &p : collider.m_points) {
+                lo = min(lo, collider.m_matRS * p);
+                hi = max(hi, collider.m_matRS * p);
+            }
+            vec3 s = hi - lo, s2 = s * s;
+            vec3 inertia = mass / 12.0f * vec3(s2.y + s2.z, s2.x + s2.z, s2.x + s2.y);
+            body.m_inv_inertia_local = vec3(1.0f) / max(inertia, vec3(EPS));
+        }
+        return add(body);
+    }
+
+    RigidBody &body( int id ) { return m_bodies[id]; }
+    const RigidBody &body( int id ) const { return m_bodies[id]; }
+    int size() const { return (int)m_bodies.size(); }
+
+    void wake( int id ) {
+        RigidBody &b = m_bodies[id];
+        if (b.is_static()) return;
+        b.m_awake = true;
+        b.m_sleep_time = 0.0f;
+    }
+
+    //move a body, e.g. when it is driven by input instead of forces
+    void set_position( int id, vec3 pos ) {
+        RigidBody &b = m_bodies[id];
+        b.m_pos = pos;
+        sync_collider(b);
+        m_tree.update(b.m_proxy, collider_aabb(*b.m_collider));
+        wake(id);
+    }
+
+    void apply_impulse( int id, vec3 impulse, vec3 point ) {
+        RigidBody &b = m_bodies[id];
+        b.m_vel += b.m_inv_mass * impulse;
+        b.m_ang_vel += b.m_inv_inertia * cross(point - b.m_pos, impulse);
+        wake(id);
+    }
+
+    void apply_force( int id, vec3 force ) {
+        m_bodies[id].m_force += force;
+        wake(id);
+    }
+
+    //true if a contact pushes the body along up, i.e. it stands on something
+    //min_cos is the cosine of the steepest slope that still counts
+    bool supported( int id, vec3 up, float min_cos = 0.7f ) const {
+        for (auto &entry : m_manifolds) {
+            const RigidManifold &m = entry.second;
+            if (m.m_points.empty() || (m.m_a != id && m.m_b != id)) continue;
+            vec3 n = m.m_a == id ? m.m_points[0].m_contact.normal : -m.m_points[0].m_contact.normal;
+            if (dot(n, up) >= min_cos) return true;
+        }
+        return false;
+    }
+
+    //advance the world by dt seconds, islands are solved in parallel on pool if given
+    void step( float dt, ThreadPool *pool = nullptr ) {
+        dt = std::min(dt, m_max_dt);
+        if (dt <= 0.0f) return;
+        m_step++;
+        find_contacts(pool);
+        build_islands();
+        run_islands(dt, pool);
+
+        //the bodies of the islands moved, the next broad phase needs their new boxes
+        for (auto &island : m_islands) {
+            for (int i : island.m_bodies) {
+                RigidBody &b = m_bodies[i];
+                m_tree.update(b.m_proxy, collider_aabb(*b.m_collider), b.m_vel * dt);
+            }
+        }
+    }
+
+    void clear() {
+        m_bodies.clear();
+        m_manifolds.clear();
+        m_tree.clear();
+        m_islands.clear();
+    }
+
+    int num_islands() const { return (int)m_islands.size(); }      //awake islands of the last step
+    int num_awake() const {
+        return (int)std::count_if(m_bodies.begin(), m_bodies.end(), []( const RigidBody &b ) { return b.active(); });
+    }
+
+private:
+    //a contact point of the pair m_pair of the current narrow phase round
+    struct PairPoint {
+        int m_pair;
+        RigidContact m_point;
+    };
+
+    struct Island {
+        std::vector<int> m_bodies;
+        std::vector<RigidManifold*> m_manifolds;
+    };
+
+    int add( RigidBody &body ) {
+        int id = (int)m_bodies.size();
+        sync_collider(body);
+        body.m_proxy = m_tree.insert(collider_aabb(*body.m_collider), id);
+        m_bodies.push_back(body);
+        return id;
+    }
+
+    static uint64_t key( int a, int b ) { return (uint64_t)(uint32_t)a << 32 | (uint32_t)b; }
+
+    static void sync_collider( RigidBody &b ) {
+        Polytope &c = *b.m_collider;
+        c.m_pos = b.m_pos;
+        c.m_matRS = b.m_rot * b.m_local;
+        c.m_matRS_inverse = inverse(c.m_matRS);
+        vec3 i = b.m_inv_inertia_local;
+        b.m_inv_inertia = b.m_rot * mat3(vec3(i.x, 0, 0), vec3(0, i.y, 0), vec3(0, 0, i.z)) * transpose(b.m_rot);
+    }
+
+    //broad and narrow phase for the awake bodies, wakes the sleeping bodies they touch
+    //runs in rounds: the pairs of the queued bodies are tested in parallel, the sleeping bodies
+    //they touch are woken and queued for the next round
+    void find_contacts( ThreadPool *pool ) {
+        std::vector<int> queue;
+        std::vector<char> queued(m_bodies.size(), 0), done(m_bodies.size(), 0);
+        for (int i = 0; i < size(); i++) {
+            if (m_bodies[i].active()) { queue.push_back(i); queued[i] = 1; }
+        }
+        for (size_t begin = 0, end; begin < queue.size(); begin = end) {
+            end = queue.size();
+            m_pairs.clear();
+            for (size_t q = begin; q < end; q++) {
+                int a = queue[q];
+                done[a] = 1;
+                m_tree.query(m_tree.fat_aabb(m_bodies[a].m_proxy), BROADPHASE_ALL_LAYERS, [&]( int proxy ) {
+                    int b = m_tree.user(proxy);
+                    if (!done[b]) m_pairs.push_back({ std::min(a, b), std::max(a, b) });   //else a itself, or b had the pair
+                    return true;
+                });
+            }
+
+            const std::vector<PairPoint> &points = m_narrow.run((int)m_pairs.size(), [&]( int i, std::vector<PairPoint> &out ) {
+                contact_points(i, *m_bodies[m_pairs[i].first].m_collider, *m_bodies[m_pairs[i].second].m_collider, out);
+            }, pool);
+
+            //the points come ordered by pair
+            for (size_t first = 0, last; first < points.size(); first = last) {
+                int pair = points[first].m_pair;
+                for (last = first + 1; last < points.size() && points[last].m_pair == pair; last++);
+                int a = m_pairs[pair].first, b = m_pairs[pair].second;
+                store_manifold(a, b, &points[first], (int)(last - first));
+                for (int body : { a, b }) {
+                    if (m_bodies[body].is_static() || queued[body]) continue;
+                    wake(body);
+                    queue.push_back(body);
+                    queued[body] = 1;
+                }
+            }
+        }
+
+        //pairs of awake bodies that were not refreshed stopped touching
+        for (auto it = m_manifolds.begin(); it != m_manifolds.end(); ) {
+            RigidManifold &m = it->second;
+            bool stale = m.m_step != m_step && (m_bodies[m.m_a].m_awake || m_bodies[m.m_b].m_awake);
+            if (stale) it = m_manifolds.erase(it);
+            else ++it;
+        }
+    }
+
+    //true if a signed distance test finds point inside the polytope, within tolerance
+    static bool inside( const Polytope &p, vec3 point, float tolerance ) {
+        for (auto &face : p.m_faces) {
+            vec3 n = face.get_face_normal();
+            float len = length(n);
+            if (len < EPS) continue;
+            n /= len;
+            vec3 p0 = p.m_matRS * p.m_points[face.face_vertices()[0]] + p.m_pos;
+            float d = dot(n, point - p0);
+            if (dot(n, p.m_pos - p0) > 0.0f) d = -d;        //make n point outward
+            if (d > tolerance) return false;
+        }
+        return true;
+    }
+
+    //contact points of the polytopes of pair, appended to out, none if they do not touch
+    //only reads the bodies, so the pairs can be tested in parallel
+    void contact_points( int pair, Polytope &pa, Polytope &pb, std::vector<PairPoint> &out ) const {
+        vec3 mtv, point;
+        if (!gjk(pa, pb, mtv, point, true)) return;
+        float depth = length(mtv);
+        if (!(depth >= EPS)) return;                //also NaN, EPA on faces that only touch
+        vec3 n = mtv / depth;           //separates a from b, so it points from b to a
+
+        //vertices of a that lie in b and of b that lie in a, depths measured along n
+        float tolerance = std::max(m_slop, 0.1f * depth);
+        float b_top = dot(pb.support(n), n), a_bottom = dot(pa.support(-n), n);
+        size_t first = out.size();
+        auto add_point = [&]( vec3 pos, int feature, float d ) {
+            if (out.size() - first >= RIGID_BODY_MAX_CONTACTS) return;
+            RigidContact c;
+            c.m_contact = { &pa, &pb, pos, n };
+            c.m_feature = feature;
+            c.m_depth = d;
+            out.push_back({ pair, c });
+        };
+        for (int i = 0; i < (int)pa.m_points.size(); i++) {
+            vec3 v = pa.m_matRS * pa.m_points[i] + pa.m_pos;
+            float d = b_top - dot(v, n);
+            if (d > -tolerance && inside(pb, v, tolerance)) add_point(v + n * (0.5f * d), i, d);
+        }
+        for (int i = 0; i < (int)pb.m_points.size(); i++) {
+            vec3 v = pb.m_matRS * pb.m_points[i] + pb.m_pos;
+            float d = dot(v, n) - a_bottom;
+            if (d > -tolerance && inside(pa, v, tolerance)) add_point(v - n * (0.5f * d), -i - 1, d);
+        }
+        //edge against edge, one point between the deepest points of both
+        if (out.size() == first) {
+            add_point((pa.support(-n) + pb.support(n)) * 0.5f, INT32_MIN, depth);
+        }
+    }
+
+    //replace the points of the manifold of bodies a < b, keeping the impulses of features that stayed
+    void store_manifold( int a, int b, const PairPoint *points, int count ) {
+        RigidManifold &m = m_manifolds[key(a, b)];
+        m.m_a = a;
+        m.m_b = b;
+        m.m_step = m_step;
+        m_old_points.swap(m.m_points);
+        m.m_points.clear();
+        for (int i = 0; i < count; i++) {
+            RigidContact c = points[i].m_point;
+            for (auto &o : m_old_points) {
+                if (o.m_feature == c.m_feature) {
+                    c.m_normal_impulse = o.m_normal_impulse;
+                    c.m_friction_impulse = o.m_friction_impulse;
+                    break;
+                }
+            }
+            m.m_points.push_back(c);
+        }
+    }
+
+    //union-find over the dynamic bodies, static bodies stay out of the islands
+    int find( int i ) {
+        while (m_parent[i] != i) i = m_parent[i] = m_parent[m_parent[i]];
+        return i;
+    }
+
+    void build_islands() {
+        m_parent.resize(m_bodies.size());
+        for (int i = 0; i < size(); i++) m_parent[i] = i;
+        for (auto &entry : m_manifolds) {
+            RigidManifold &m = entry.second;
+            if (m.m_step != m_step || m_bodies[m.m_a].is_static() || m_bodies[m.m_b].is_static()) continue;
+            m_parent[find(m.m_a)] = find(m.m_b);
+        }
+
+        m_islands.clear();
+        std::vector<int> island_of(m_bodies.size(), -1);
+        for (int i = 0; i < size(); i++) {
+            if (!m_bodies[i].active()) continue;
+            int root = find(i);
+            if (island_of[root] < 0) {
+                island_of[root] = (int)m_islands.size();
+                m_islands.emplace_back();
+            }
+            m_islands[island_of[root]].m_bodies.push_back(i);
+        }
+        for (auto &entry : m_manifolds) {
+            RigidManifold &m = entry.second;
+            if (m.m_step != m_step) continue;
+            int body = m_bodies[m.m_a].is_static() ? m.m_b : m.m_a;
+            m_islands[island_of[find(body)]].m_manifolds.push_back(&m);
+        }
+    }
+
+    //solve the islands, on pool in as many jobs as it has threads, the largest islands first
+    void run_islands( float dt, ThreadPool *pool ) {
+        int jobs = pool != nullptr ? std::min((int)pool->threadCount(), (int)m_islands.size()) : 1;
+        if (jobs <= 1) {
+            for (auto &island : m_islands) solve_island(island, dt);
+            return;
+        }
+        std::vector<int> order(m_islands.size());
+        for (int i = 0; i < (int)order.size(); i++) order[i] = i;
+        std::sort(order.begin(), order.end(), [&]( int x, int y ) {
+            return m_islands[x].m_bodies.size() + m_islands[x].m_manifolds.size() > m_islands[y].m_bodies.size() + m_islands[y].m_manifolds.size();
+        });
+        std::vector<std::vector<int>> work(jobs);
+        std::vector<size_t> load(jobs, 0);
+        for (int i : order) {
+            int j = (int)(std::min_element(load.begin(), load.end()) - load.begin());
+            work[j].push_back(i);
+            load[j] += m_islands[i].m_bodies.size() + m_islands[i].m_manifolds.size();
+        }
+        auto job = [&]( int j ) {
+            for (int i : work[j]) solve_island(m_islands[i], dt);
+        };
+        std::vector<std::future<void>> futures;
+        for (int j = 0; j < jobs; j++) futures.push_back(pool->add(job, j));
+        for (auto &f : futures) f.get();
+    }
+
+    //velocity of body at the offset r from its center of mass
+    static vec3 point_velocity( const RigidBody &body, vec3 r ) {
+        return body.m_vel + cross(body.m_ang_vel, r);
+    }
+
+    //inverse effective mass of the pair along dir
+    static float effective_mass( const RigidBody &a, const RigidBody &b, vec3 ra, vec3 rb, vec3 dir ) {
+        vec3 ca = cross(ra, dir), cb = cross(rb, dir);
+        float k = a.m_inv_mass + b.m_inv_mass + dot(ca, a.m_inv_inertia * ca) + dot(cb, b.m_inv_inertia * cb);
+        return k > 0.0f ? 1.0f / k : 0.0f;
+    }
+
+    //impulse p acts on a, -p on b
+    //static bodies are shared by the islands solved in parallel, they are never written
+    static void apply( RigidBody &a, RigidBody &b, vec3 ra, vec3 rb, vec3 p ) {
+        if (!a.is_static()) {
+            a.m_vel += a.m_inv_mass * p;
+            a.m_ang_vel += a.m_inv_inertia * cross(ra, p);
+        }
+        if (!b.is_static()) {
+            b.m_vel -= b.m_inv_mass * p;
+            b.m_ang_vel -= b.m_inv_inertia * cross(rb, p);
+        }
+    }
+
+    void solve_island( Island &island, float dt ) {
+        for (int i : island.m_bodies) {
+            RigidBody &b = m_bodies[i];
+            b.m_vel += dt * (m_gravity + b.m_inv_mass * b.m_force);
+            b.m_ang_vel += dt * (b.m_inv_inertia * b.m_torque);
+            b.m_force = b.m_torque = vec3(0.0f);
+        }
+
+        //prepare the contacts and apply the impulses of the last step
+        for (RigidManifold *m : island.m_manifolds) {
+            RigidBody &a = m_bodies[m->m_a], &b = m_bodies[m->m_b];
+            float friction = std::sqrt(a.m_friction * b.m_friction);
+            for (auto &c : m->m_points) {
+                vec3 n = c.m_contact.normal;
+                c.m_ra = c.m_contact.pos - a.m_pos;
+                c.m_rb = c.m_contact.pos - b.m_pos;
+                c.m_tangent[0] = std::abs(n.x) > 0.57735f ? normalize(vec3(n.y, -n.x, 0.0f)) : normalize(vec3(0.0f, n.z, -n.y));
+                c.m_tangent[1] = cross(n, c.m_tangent[0]);
+                c.m_normal_mass = effective_mass(a, b, c.m_ra, c.m_rb, n);
+                for (int t = 0; t < 2; t++) c.m_tangent_mass[t] = effective_mass(a, b, c.m_ra, c.m_rb, c.m_tangent[t]);
+                c.m_bias = m_baumgarte / dt * std::max(c.m_depth - m_slop, 0.0f);
+
+                //the friction impulse of the last step, projected onto the new tangent plane
+                c.m_friction_impulse -= n * dot(n, c.m_friction_impulse);
+                if (length(c.m_friction_impulse) > friction * c.m_normal_impulse) c.m_friction_impulse = vec3(0.0f);
+                apply(a, b, c.m_ra, c.m_rb, n * c.m_normal_impulse + c.m_friction_impulse);
+            }
+        }
+
+        for (int it = 0; it < m_iterations; it++) {
+            for (RigidManifold *m : island.m_manifolds) {
+                RigidBody &a = m_bodies[m->m_a], &b = m_bodies[m->m_b];
+                float friction = std::sqrt(a.m_friction * b.m_friction);
+                for (auto &c : m->m_points) {
+                    vec3 n = c.m_contact.normal;
+
+                    //friction, clamped to the cone of the current normal impulse
+                    vec3 dv = point_velocity(a, c.m_ra) - point_velocity(b, c.m_rb);
+                    vec3 old = c.m_friction_impulse;
+                    for (int t = 0; t < 2; t++) c.m_friction_impulse -= c.m_tangent[t] * (c.m_tangent_mass[t] * dot(dv, c.m_tangent[t]));
+                    float limit = friction * c.m_normal_impulse, len = length(c.m_friction_impulse);
+                    if (len > limit) c.m_friction_impulse *= limit / len;
+                    apply(a, b, c.m_ra, c.m_rb, c.m_friction_impulse - old);
+
+                    //normal, the accumulated impulse may only push
+                    dv = point_velocity(a, c.m_ra) - point_velocity(b, c.m_rb);
+                    float dp = c.m_normal_mass * (c.m_bias - dot(dv, n));
+                    float acc = std::max(c.m_normal_impulse + dp, 0.0f);
+                    dp = acc - c.m_normal_impulse;
+                    c.m_normal_impulse = acc;
+                    apply(a, b, c.m_ra, c.m_rb, n * dp);
+                }
+            }
+        }
+
+        //integrate, and put the island to sleep if all of its bodies have been slow long enough
+        float min_sleep_time = std::numeric_limits<float>::max();
+        for (int i : island.m_bodies) {
+            RigidBody &b = m_bodies[i];
+            b.m_pos += dt * b.m_vel;
+            float w = length(b.m_ang_vel);
+            if (w > 0.0f) {
+                mat3 rot = mat3(rotate(mat4(1.0f), w * dt, b.m_ang_vel / w)) * b.m_rot;
+                rot[0] = normalize(rot[0]);                             //keep it orthonormal
+                rot[1] = normalize(rot[1] - rot[0] * dot(rot[0], rot[1]));
+                rot[2] = cross(rot[0], rot[1]);
+                b.m_rot = rot;
+            }
+            sync_collider(b);
+
+            bool slow = length(b.m_vel) < m_sleep_linear && w < m_sleep_angular;
+            b.m_sleep_time = slow ? b.m_sleep_time + dt : 0.0f;
+            min_sleep_time = std::min(min_sleep_time, b.m_sleep_time);
+        }
+        if (min_sleep_time >= m_time_to_sleep) {
+            for (int i : island.m_bodies) {
+                RigidBody &b = m_bodies[i];
+                b.m_awake = false;
+                b.m_vel = b.m_ang_vel = vec3(0.0f);
+            }
+        }
+    }
+
+    std::vector<RigidBody> m_bodies;
+    std::unordered_map<uint64_t, RigidManifold> m_manifolds;     //by key(a, b)
+    AABBTree m_tree;
+    std::vector<Island> m_islands;
+    std::vector<int> m_parent;
+    std::vector<std::pair<int, int>> m_pairs;      //candidate pairs of a narrow phase round, first < second
+    NarrowPhase<PairPoint> m_narrow;
+    std::vector<RigidContact> m_old_points;
+    uint32_t m_step = 0;
+};
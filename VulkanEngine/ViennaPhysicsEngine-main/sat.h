@@ -10,6 +10,7 @@
 
 #include "collider.h"
 #include <random>
+#include <vector>
 
 
 constexpr int NUM_RANDOM_DIR = 32;
@@ -33,34 +34,39 @@ bool sat_axis_test( ICollider &obj1, ICollider &obj2, vec3 &dir ) {
 
 
 
-//choose N random directions to find SA
-//returns true if a separating axis was found (i.e. objects are NOT in contact), else false
-bool sat_random_test( ICollider &obj1, ICollider &obj2, vec3 &dir) {
-    static std::vector<vec3> random_axes;   //Fibonacci sphere
-    if( random_axes.empty()) {
-        float phi = (float)(M_PI * (3. - std::sqrt(5.)));  // golden angle in radians
+//NUM_RANDOM_DIR directions spread evenly over the unit sphere (Fibonacci sphere)
+std::vector<vec3> fibonacci_sphere() {
+    std::vector<vec3> axes;
+    float phi = (float)(M_PI * (3. - std::sqrt(5.)));  // golden angle in radians
 
-        for(int i=0; i<NUM_RANDOM_DIR; ++i ) {
-            float y = 1 - (i / float(NUM_RANDOM_DIR - 1)) * 2;  // y goes from 1 to -1
-            float radius = std::sqrt(1 - y * y);         // radius at y
+    for(int i=0; i<NUM_RANDOM_DIR; ++i ) {
+        float y = 1 - (i / float(NUM_RANDOM_DIR - 1)) * 2;  // y goes from 1 to -1
+        float radius = std::sqrt(1 - y * y);         // radius at y
 
-            float theta = phi * i;                       // golden angle increment
+        float theta = phi * i;                       // golden angle increment
 
-            float x = std::cos(theta) * radius;
-            float z = std::sin(theta) * radius;
-            random_axes.emplace_back( x, y, z );
-        }
+        float x = std::cos(theta) * radius;
+        float z = std::sin(theta) * radius;
+        axes.emplace_back( x, y, z );
     }
+    return axes;
+}
+
+//choose N random directions to find SA
+//returns true if a separating axis was found (i.e. objects are NOT in contact), else false
+bool sat_random_test( ICollider &obj1, ICollider &obj2, vec3 &dir) {
+    static const std::vector<vec3> random_axes = fibonacci_sphere();   //initialized once, also with several threads
 
     vec3 r;
     float d;
     float max = -1.0e6;
     bool found = false;
     for( int i=0; i<random_axes.size() && !found; ++i ) {        
-        found = sat_axis_test(obj1, obj2, random_axes[i], r, d);
+        vec3 axis = random_axes[i];
+        found = sat_axis_test(obj1, obj2, axis, r, d);
         if( d>max ) { 
             max = d;
-            dir = random_axes[i];
+            dir = axis;
         }
     }
     return found;
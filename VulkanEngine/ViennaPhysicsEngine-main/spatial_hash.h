@@ -0,0 +1,219 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <future>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/ext.hpp>
+
+#include <ThreadPool.h>
+
+#include "collider.h"
+#include "broadphase.h"
+
+//Broad phase for many small colliders that all move every frame (bullets, enemies).
+//Space is cut into cubic cells of cell_size, a cell (x, y, z) maps to one of a power of two
+//number of buckets by hashing its quantized coordinates, so the world needs no bounds.
+//An item is stored in the bucket of every cell its AABB overlaps. A query visits the cells
+//of its box, so its cost depends on how crowded they are, not on how many items there are.
+//
+//Instead of updating items in place the hash is refilled every frame: clear(), add() every
+//collider, build(). build() is a counting sort of (bucket, item) pairs into one flat array.
+//With a ThreadPool the items are split into chunks, each chunk bins its items into its own
+//buckets and counts them, a prefix sum over all chunks gives every chunk its slots, and the
+//chunks copy their pairs there in parallel. No locks, and the result is the same as serial.
+//
+//Items much larger than a cell cover many buckets, static level geometry belongs in the AABBTree.
+
+
+constexpr int SPATIAL_HASH_CHUNK = 2048;        //fewest items per parallel chunk
+
+class SpatialHash {
+public:
+    SpatialHash( float cell_size = 4.0f, int num_buckets = 4096 ) {
+        set_cell_size(cell_size);
+        resize_buckets(num_buckets);
+    }
+
+    void set_cell_size( float cell_size ) { m_cell_size = cell_size; m_inv_cell_size = 1.0f / cell_size; }
+    float cell_size() const { return m_cell_size; }
+
+    //remove all items, the buckets are stale until the next build()
+    void clear() {
+        m_items.clear();
+        m_entries.clear();
+        std::fill(m_start.begin(), m_start.end(), 0);
+    }
+
+    //add an item, returns its index, which is what queries report
+    int add( const AABB &box, int user, uint32_t layer = 1 ) {
+        m_items.push_back({ box, user, layer });
+        return (int)m_items.size() - 1;
+    }
+
+    //sort the items into their buckets, in parallel on pool if there are enough of them
+    void build( ThreadPool *pool = nullptr ) {
+        int n = size();
+        if (n > num_buckets()) {
+            int buckets = num_buckets();
+            while (buckets < n) buckets *= 2;
+            resize_buckets(buckets);
+        }
+        int chunks = 1;
+        if (pool != nullptr && n >= 2 * SPATIAL_HASH_CHUNK) {
+            chunks = std::max(1, std::min((int)pool->threadCount(), n / SPATIAL_HASH_CHUNK));
+        }
+        if ((int)m_chunks.size() < chunks) m_chunks.resize(chunks);
+
+        //per chunk: the (bucket, item) pairs of its items and how many fall into each bucket
+        auto bin = [&]( int c ) {
+            Chunk &chunk = m_chunks[c];
+            chunk.m_counts.assign(num_buckets(), 0);
+            chunk.m_pairs.clear();
+            for (int i = n * c / chunks; i < n * (c + 1) / chunks; i++) {
+                buckets_of(m_items[i].m_box, chunk.m_scratch);
+                for (int b : chunk.m_scratch) {
+                    chunk.m_pairs.push_back({ b, i });
+                    chunk.m_counts[b]++;
+                }
+            }
+        };
+        run(pool, chunks, bin);
+
+        //bucket major, chunk minor, so every bucket lists its items in the order they were added
+        int total = 0;
+        for (int b = 0; b < num_buckets(); b++) {
+            m_start[b] = total;
+            for (int c = 0; c < chunks; c++) {
+                int count = m_chunks[c].m_counts[b];
+                m_chunks[c].m_counts[b] = total;
+                total += count;
+            }
+        }
+        m_start[num_buckets()] = total;
+        m_entries.resize(total);
+
+        auto scatter = [&]( int c ) {
+            Chunk &chunk = m_chunks[c];
+            for (const auto &pair : chunk.m_pairs) m_entries[chunk.m_counts[pair.first]++] = pair.second;
+        };
+        run(pool, chunks, scatter);
+    }
+
+    //call f(item) once for every item whose AABB overlaps box and whose layer matches mask
+    //f may return false to stop the query
+    template<typename F>
+    void query( const AABB &box, uint32_t mask, F&& f ) const {
+        int x0 = cell(box.m_min.x), y0 = cell(box.m_min.y), z0 = cell(box.m_min.z);
+        int x1 = cell(box.m_max.x), y1 = cell(box.m_max.y), z1 = cell(box.m_max.z);
+        for (int z = z0; z <= z1; z++) {
+            for (int y = y0; y <= y1; y++) {
+                for (int x = x0; x <= x1; x++) {
+                    int b = bucket(x, y, z);
+                    for (int e = m_start[b]; e < m_start[b + 1]; e++) {
+                        const Item &item = m_items[m_entries[e]];
+                        if (!(item.m_layer & mask) || !item.m_box.overlaps(box)) continue;
+                        //an item in several cells of the box is reported only from the cell
+                        //holding the lower corner of the overlap, a colliding bucket only there too
+                        if (cell(std::max(item.m_box.m_min.x, box.m_min.x)) != x ||
+                            cell(std::max(item.m_box.m_min.y, box.m_min.y)) != y ||
+                            cell(std::max(item.m_box.m_min.z, box.m_min.z)) != z) continue;
+                        if (!f(m_entries[e])) return;
+                    }
+                }
+            }
+        }
+    }
+
+    //items overlapping the cube of half size radius around center
+    template<typename F>
+    void query_radius( vec3 center, float radius, uint32_t mask, F&& f ) const {
+        query({ center - vec3(radius), center + vec3(radius) }, mask, std::forward<F>(f));
+    }
+
+    //call f(item_a, item_b) once for every pair of items whose AABBs overlap and whose layers both match mask
+    //f may return false to stop
+    template<typename F>
+    void query_pairs( F&& f, uint32_t mask = BROADPHASE_ALL_LAYERS ) const {
+        for (int a = 0; a < size(); a++) {
+            if (!(m_items[a].m_layer & mask)) continue;
+            bool go_on = true;
+            query(m_items[a].m_box, mask, [&]( int b ) {
+                if (b > a) go_on = f(a, b);
+                return go_on;
+            });
+            if (!go_on) return;
+        }
+    }
+
+    int user( int item ) const { return m_items[item].m_user; }
+    uint32_t layer( int item ) const { return m_items[item].m_layer; }
+    const AABB &aabb( int item ) const { return m_items[item].m_box; }
+    int size() const { return (int)m_items.size(); }
+    int num_buckets() const { return (int)m_start.size() - 1; }
+
+private:
+    struct Item {
+        AABB m_box;
+        int m_user;
+        uint32_t m_layer;
+    };
+
+    //one per parallel job of build()
+    struct Chunk {
+        std::vector<std::pair<int, int>> m_pairs;   //(bucket, item)
+        std::vector<int> m_counts;                  //items per bucket, then the next slot per bucket
+        std::vector<int> m_scratch;
+    };
+
+    int cell( float v ) const { return (int)std::floor(v * m_inv_cell_size); }
+
+    int bucket( int x, int y, int z ) const {
+        uint32_t h = (uint32_t)x * 73856093u ^ (uint32_t)y * 19349663u ^ (uint32_t)z * 83492791u;
+        return (int)(h & m_bucket_mask);
+    }
+
+    //distinct buckets of the cells box overlaps
+    void buckets_of( const AABB &box, std::vector<int> &out ) const {
+        out.clear();
+        for (int z = cell(box.m_min.z); z <= cell(box.m_max.z); z++) {
+            for (int y = cell(box.m_min.y); y <= cell(box.m_max.y); y++) {
+                for (int x = cell(box.m_min.x); x <= cell(box.m_max.x); x++) out.push_back(bucket(x, y, z));
+            }
+        }
+        if (out.size() > 1) {
+            std::sort(out.begin(), out.end());
+            out.erase(std::unique(out.begin(), out.end()), out.end());
+        }
+    }
+
+    void resize_buckets( int num_buckets ) {
+        int buckets = 1;
+        while (buckets < num_buckets) buckets *= 2;
+        m_bucket_mask = (uint32_t)buckets - 1;
+        m_start.assign(buckets + 1, 0);
+        m_entries.clear();
+    }
+
+    //job(c) for every chunk c, on pool if there is more than one
+    template<typename F>
+    static void run( ThreadPool *pool, int chunks, F &job ) {
+        if (chunks == 1) {
+            job(0);
+            return;
+        }
+        std::vector<std::future<void>> jobs;
+        for (int c = 0; c < chunks; c++) jobs.push_back(pool->add(job, c));
+        for (auto &j : jobs) j.get();
+    }
+
+    float m_cell_size = 4.0f;
+    float m_inv_cell_size = 0.25f;
+    uint32_t m_bucket_mask = 0;
+    std::vector<Item> m_items;
+    std::vector<int> m_start;       //first entry of each bucket, plus the end
+    std::vector<int> m_entries;     //items sorted by bucket
+    std::vector<Chunk> m_chunks;
+};
@@ -20,380 +20,34 @@
 #include <algorithm>
 #include <iterator>
 #include <list>
+#include <atomic>
+#include <future>
 #include <unordered_map>
 #include <unordered_set>
 
 #include "ViennaPhysicsEngine-main/sat.h"
 #include "ViennaPhysicsEngine-main/gjk_epa.h"
 #include "ViennaPhysicsEngine-main/contact.h"
+#include "ViennaPhysicsEngine-main/collide.h"
+#include "ViennaPhysicsEngine-main/box_batch.h"
+#include "ViennaPhysicsEngine-main/broadphase.h"
+#include "ViennaPhysicsEngine-main/spatial_hash.h"
+#include "ViennaPhysicsEngine-main/rigid_body.h"
+#include "ViennaPhysicsEngine-main/ccd.h"
+
+#include "Pathfinding/pathfinding.h"
+#include "Pathfinding/path_service.h"
+#include "Pathfinding/level_layout.h"
+#include "Pathfinding/nav_cache.h"
+#include "Pathfinding/navmesh.h"
+#include "Pathfinding/pvs.h"
+#include "AI/npc_system.h"
+#include "AI/ai_scheduler.h"
 
 using namespace std;
 
 bool winner = false;
 
-struct Cell {
-    int x, y;
-    double weight;
-    Cell() {
-        
-    }
-    
-    Cell(Cell *cell) {
-        x = cell->x;
-        y = cell->y;
-        weight = cell->weight;
-    }
-    
-    Cell(int x_, int y_, double weight_):
-    x(x_), y(y_), weight(weight_) {}
-    
-    Cell(int x_, int y_):
-    x(x_), y(y_) {}
-};
-
-namespace std {
-    template <> struct hash<Cell> {
-        typedef Cell argument_type;
-        typedef std::size_t result_type;
-        std::size_t operator()(const Cell& id) const noexcept {
-            return std::hash<int>()(id.x ^ (id.y << 4));
-        }
-    };
-}
-
-bool operator == (Cell a, Cell b) {
-    return a.x == b.x && a.y == b.y;
-}
-
-bool operator != (Cell a, Cell b) {
-    return a.x != b.x || a.y != b.y;
-}
-
-bool operator < (Cell a, Cell b) {
-  return std::tie(a.x, a.y) < std::tie(b.x, b.y);
-}
-
-enum State{IDLE, MOVE, ATTACK, ESCAPE};
-
-struct NPC {
-    Cell pos;
-    State state;
-    int health;
-    int weapon;
-    bool right;
-    string name;
-    
-    NPC() {
-        
-    }
-    
-    NPC(Cell pos_, string name_): pos(pos_), name(name_) {
-        state = IDLE;
-        health = 100;
-        weapon = 3;
-        static auto gen = std::bind(std::uniform_int_distribution<>(0,1),std::default_random_engine());
-        right = gen();
-    }
-    
-    NPC(int x, int y, string name_): name(name_) {
-        pos = new Cell(x, y);
-        state = IDLE;
-        health = 50;
-        weapon = 3;
-        static auto gen = std::bind(std::uniform_int_distribution<>(0,1),std::default_random_engine());
-        right = gen();
-    }
-    
-    void craft_weapons() {
-        weapon += 3;
-    }
-    
-    void heal() {
-        health += 5;
-    }
-    
-    void move(int x, int y) {
-        pos = new Cell(x, y);
-    }
-    
-    void move(Cell x) {
-        pos = new Cell(x.x, x.y);
-    }
-    
-    void attack() {
-        weapon--;
-    }
-    
-    void getAttacked() {
-        health -= 10;
-    }
-    
-    void changeState(State new_state) {
-        state = new_state;
-    }
-    
-    void patrol() {
-        if (pos.y >= 9) {
-            right = false;
-        }
-        if (pos.y <= 0) {
-            right = true;
-        }
-        
-        if (right) {
-            pos = new Cell(pos.x, pos.y + 1);
-        } else {
-            pos = new Cell(pos.x, pos.y - 1);
-        }
-    }
-};
-
-struct Grid {
-    int width, height;
-    vector<vector<Cell>> cells;
-    std::unordered_set<Cell> walls;
-    vector<NPC> teamA;
-    vector<NPC> teamB;
-    
-    Grid(int width_, int height_)
-         : width(width_), height(height_) {
-             for (int i = 0; i < width_; i++) {
-                 vector<Cell> temp;
-                 for (int j = 0; j < height_; j++) {
-                     temp.push_back(Cell(i, j, 1.0));
-                 }
-                 cells.push_back(temp);
-             }
-         }
-
-    void add_team_A(vector<NPC> team) {
-        teamA = team;
-    }
-    
-    void  add_team_B(vector<NPC> team) {
-        teamB = team;
-    }
-    
-    void add_wall(int x, int y) {
-        walls.insert(new Cell(x, y));
-    }
-    
-    bool if_in_bounds(Cell id) {
-        return 0 <= id.x && id.x < width
-            && 0 <= id.y && id.y < height;
-    }
-    
-    bool passable(Cell id) {
-        return walls.find(id) == walls.end();
-    }
-    
-    void add_weight(int x, int y, double weight) {
-        if (if_in_bounds(Cell(x,y))) {
-            cells[x][y] = Cell(x, y, weight);
-        }
-    }
-    
-    void print_map() {
-        for (int i = 0; i < width; i++) {
-            for (int j = 0; j < height; j++) {
-                cout << cells[i][j].weight;
-                if (cells[i][j].weight == 1) {
-                    cout << ".0";
-                }
-                if (j != height - 1) {
-                    cout << " - ";
-                }
-            }
-            cout << endl;
-        }
-        cout << endl;
-    }
-    
-    vector<Cell> get_neighbours(Cell current) {
-        vector<Cell> results;
-        double x = current.x;
-        double y = current.y;
-        
-        if (if_in_bounds(Cell(x, y+1)) && passable(Cell(x, y+1))) {
-            Cell down(cells[x][y+1]);
-            results.push_back(down);
-        }
-        
-        if (if_in_bounds(Cell(x, y-1)) && passable(Cell(x, y-1))) {
-            Cell up(cells[x][y-1]);
-            results.push_back(up);
-        }
-        
-        if (if_in_bounds(Cell(x-1, y)) && passable(Cell(x-1, y))) {
-            Cell left(cells[x-1][y]);
-            results.push_back(left);
-        }
-        
-        if (if_in_bounds(Cell(x+1, y)) && passable(Cell(x+1, y))) {
-            Cell right(cells[x+1][y]);
-            results.push_back(right);
-        }
-        
-        if (if_in_bounds(Cell(x-1, y-1)) && passable(Cell(x-1, y-1))) {
-            Cell left_up(cells[x-1][y-1]);
-            results.push_back(left_up);
-        }
-        
-        if (if_in_bounds(Cell(x+1, y-1)) && passable(Cell(x+1, y-1))) {
-            Cell right_up(cells[x+1][y-1]);
-            results.push_back(right_up);
-        }
-        
-        if (if_in_bounds(Cell(x-1, y+1)) && passable(Cell(x-1, y+1))) {
-            Cell left_down(cells[x-1][y+1]);
-            results.push_back(left_down);
-        }
-        
-        if (if_in_bounds(Cell(x+1, y+1)) && passable(Cell(x+1, y+1))) {
-            Cell right_down(cells[x+1][y+1]);
-            results.push_back(right_down);
-        }
-        
-        return results;
-    }
-};
-
-Grid create_map() {
-    Grid grid(400, 400);
-    return grid;
-}
-
-inline double heuristic(Cell current, Cell find) {
-  return std::abs(current.x - find.x) + std::abs(current.y - find.y);
-}
-
-template<typename T, typename priority_t>
-struct PriorityQueue {
-  typedef std::pair<priority_t, T> PQElement;
-  std::priority_queue<PQElement, std::vector<PQElement>,
-                 std::greater<PQElement>> elements;
-
-  inline bool empty() const {
-     return elements.empty();
-  }
-
-  inline void put(T item, priority_t priority) {
-    elements.emplace(priority, item);
-  }
-
-  T get() {
-    T best_item = elements.top().second;
-    elements.pop();
-    return best_item;
-  }
-};
-
-void a_star (Grid grid,
-             Cell start,
-             Cell end,
-             unordered_map<Cell, Cell>& parent,
-             unordered_map<Cell, double>& cost) {
-    PriorityQueue<Cell, double> open;
-    open.put(start, 0);
-
-    parent[start] = start;
-    cost[start] = 0;
-  
-    while (!open.empty()) {
-        Cell current = open.get();
-
-        if (current == end) {
-            break;
-        }
-
-        for (Cell next : grid.get_neighbours(current)) {
-            double new_cost = cost[current] + next.weight * 10;
-            if (cost.find(next) == cost.end() || new_cost < cost[next]) {
-                cost[next] = new_cost;
-                double priority = new_cost + heuristic(next, end);
-                open.put(next, priority);
-                parent[next] = current;
-            }
-        }
-    }
-}
-
-void print_path(
-    Cell start, Cell end, unordered_map<Cell, Cell> parent,
-               unordered_map<int, string> heights) {
-    vector<string> path;
-    Cell current = end;
-    
-    while (current != start) {
-        path.push_back(heights[current.y] + to_string(current.x+1));
-        current = parent[current];
-    }
-    
-    reverse(path.begin(), path.end());
-    
-    cout << heights[start.y] + to_string(start.x+1) << endl;
-    for (string line: path) {
-        cout << line << endl;
-    }
-}
-
-void loadWallsLogic(Grid &g) {
-    //1
-    for (int i = 50; i <= 150; i++) {
-        for (int j = 70; j <= 80; j++) {
-            g.add_wall(j, i);
-        }
-    }
-    //2
-    for (int i = 70; i <= 170; i++) {
-        for (int j = 40; j <= 50; j++) {
-            g.add_wall(i, j);
-        }
-    }
-    //3
-    for (int i = 230; i <= 240; i++) {
-        for (int j = 150; j <= 250; j++) {
-            g.add_wall(i, j);
-        }
-    }
-    //4
-    for (int i = 150; i <= 230; i++) {
-        for (int j = 240; j <= 250; j++) {
-            g.add_wall(i, j);
-        }
-    }
-    //5
-    for (int i = 120; i <= 130; i++) {
-        for (int j = 300; j <= 400; j++) {
-            g.add_wall(i, j);
-        }
-    }
-    //6
-    for (int i = 20; i <= 120; i++) {
-        for (int j = 390; j <= 400; j++) {
-            g.add_wall(i, j);
-        }
-    }
-    //7
-    for (int i = 250; i <= 260; i++) {
-        for (int j = 300; j <= 400; j++) {
-            g.add_wall(i, j);
-        }
-    }
-    //8
-    for (int i = 260; i <= 360; i++) {
-        for (int j = 300; j <= 310; j++) {
-            g.add_wall(i, j);
-        }
-    }
-    //9
-    for (int i = 270; i <= 280; i++) {
-        for (int j = 100; j <= 200; j++) {
-            g.add_wall(i, j);
-        }
-    }
-}
-
 Box new_box{ {2.0f, 6.0f, 2.0f}, scale( mat4(1.0f), vec3(1.0f, 10.0f, 1.0f))};
 Box player = new_box;
 
@@ -409,10 +63,94 @@ Box enemies[5]= {enemy1, enemy2, enemy3, enemy4, enemy5};
 
 vector<Box> wallsValues;
 
-vector<Box> floors;
+//broad phase layers, the user value of a proxy or item indexes the vector of its layer
+enum ColliderLayer : uint32_t {
+    LAYER_WALL = 1,     //wallsValues
+    LAYER_ENEMY = 4     //enemies
+};
+AABBTree colliderTree;          //static level colliders
+BoxBatch wallBatch;             //wallsValues in SoA layout for the batched overlap test
+SpatialHash movingHash(4.0f);   //enemies, refilled every frame after they moved
 vector<int> killedEnemies;
 
-Grid grid = create_map();
+RigidBodyWorld physicsWorld;    //the player on static walls, floors and ground
+int playerBody = -1;
+const vec3 PLAYER_GRAVITY(0.0f, -9.8f * 60.0f, 0.0f);  //the old jump lost 9.8 units/s every frame at 60 fps
+const float PLAYER_JUMP_SPEED = 100.0f;
+const float PLAYER_SKIN = 0.1f;     //the wall test lifts the player this much off what it stands on, more than the solver slop
+
+//true if c overlaps one of boxes, which are the colliders of layer and stored in batch in the same order
+//the tree picks the candidates, the batch tests them several at a time
+bool overlapsStatic(Box &c, uint32_t layer, vector<Box> &boxes, const BoxBatch &batch) {
+    vector<int> candidates, hits;
+    colliderTree.query(collider_aabb(c), layer, [&](int proxy) {
+        candidates.push_back(colliderTree.user(proxy));
+        return true;
+    });
+    OrientedBox box;
+    if (!oriented_box(c, box)) {
+        for (int i : candidates) {
+            if (collide(c, boxes[i])) return true;
+        }
+        return false;
+    }
+    batch.overlap(box, candidates.data(), (int)candidates.size(), hits);
+    return !hits.empty();
+}
+
+//put the current enemy colliders into movingHash
+void rebuildMovingHash(ThreadPool *pool = nullptr) {
+    movingHash.clear();
+    int size = *(&enemies + 1) - enemies;
+    for (int i = 0; i < size; i++) movingHash.add(collider_aabb(enemies[i]), i, LAYER_ENEMY);
+    movingHash.build(pool);
+}
+
+//world-space bounds of a static collider, read off its support function
+NavCollider navCollider(Collider &c) {
+    NavCollider n;
+    n.x0 = c.support(vec3(-1, 0, 0)).x;  n.x1 = c.support(vec3(1, 0, 0)).x;
+    n.y0 = c.support(vec3(0, -1, 0)).y;  n.y1 = c.support(vec3(0, 1, 0)).y;
+    n.z0 = c.support(vec3(0, 0, -1)).z;  n.z1 = c.support(vec3(0, 0, 1)).z;
+    return n;
+}
+
+NavGrid grid;                   //baked from the static colliders when a level is loaded
+const char *NAV_CACHE_DIR = "cache";                     //generated files, kept out of the media assets
+const char *NAV_CACHE_FILE = "cache/level1.navgrid";    //baked grid of level one, rebuilt when the colliders change
+JumpTable jumpTable;            //precomputed straight jumps for PATH_JPS, rebuilt when the level is loaded
+HpaGraph hpaGraph;              //cluster abstraction for long queries, built with the jump table
+PotentiallyVisibleSet pvs;      //which grid regions can see each other, loaded with the grid or built in the background
+const char *PVS_CACHE_FILE = "cache/level1.pvs";
+std::future<PotentiallyVisibleSet> pvsBuild;    //build after a cache miss, swapped into pvs when it is done
+std::atomic<bool> pvsCancel(false);             //stops pvsBuild when the level is reloaded or the game ends
+Landmarks landmarks;            //ALT distance tables that tighten the heuristic of every grid search
+const int NUM_LANDMARKS = 8;
+PathMode pathMode = PATH_JPS;
+const int HPA_MIN_DISTANCE = 64;    //queries spanning more cells than this use PATH_HPA
+
+//how enemies find their way to the player
+enum ChaseMode {
+    CHASE_PATH,         //every enemy plans its own path with pathMode, time-sliced by aiScheduler
+    CHASE_PATH_ASYNC,   //like CHASE_PATH, but the searches run on the engine thread pool
+    CHASE_INCREMENTAL,  //every enemy keeps a D* Lite planner that is repaired as the player moves
+    CHASE_FLOW_FIELD,   //all enemies follow one shared flow field toward the player
+    CHASE_NAVMESH       //every enemy walks a funnel-smoothed navMesh path, off the cell grid
+};
+ChaseMode chaseMode = CHASE_FLOW_FIELD;
+FlowField flowField;
+LosCache losCache;              //line of sight results of the current frame, shared by all enemies
+PathService pathService;        //path requests of CHASE_PATH_ASYNC, worker threads are set at level load
+const int FLOW_FIELD_BUDGET = 10000;    //cells integrated per step while the field is rebuilt
+const int CHASE_RADIUS = 60;            //enemies this close to the player on both axes chase it, the flow field covers no more
+NavMesh navMesh;                //walkable area of the level as convex polygons, built with the grid
+const float NAVMESH_REPLAN_DISTANCE = 4.0f;     //replan once the player is this far from the end of the path
+const float NAVMESH_ARRIVE_DISTANCE = 0.5f;     //a path point this close counts as reached
+const float PATH_ARRIVE_DISTANCE = 0.5f;        //a waypoint centre this close counts as reached
+NpcSystem npcs;                 //state of the enemies, npc id i is enemies[i]
+AiScheduler aiScheduler;        //path searches of CHASE_PATH, nearest enemy first within AI_BUDGET_US per frame
+const double AI_BUDGET_US = 1000.0;
+const int PLAYER_BULLET_DAMAGE = 100;
 
 namespace ve {
 	///simple event listener for rotating objects
@@ -532,21 +270,22 @@ namespace ve {
                 bullet.m_pos = pObject->getPosition();
         };
 
-        void onFrameStarted(veEvent event) {
+        ///sweeps the bullet over the way it moved this frame, so it hits at any frame rate
+        void onSimulationStep(veEvent event) {
             glm::vec3 acceleration = direction * 100;
             m_pObject->multiplyTransform(glm::translate(glm::mat4(1.0f), acceleration * event.dt));
-            bullet.m_pos = m_pObject->getPosition();
-            
-            int size = *(&enemies + 1) - enemies;
-            for(int i = 0; i < size; i++) {
-                vec3 p;
-                vec3 mtv = glm::vec3(0, 0.0f, 0);
-                auto hit1 = gjk( bullet, enemies[i], mtv, p, true);
-                if (hit1) {
+            vec3 motion = m_pObject->getPosition() - bullet.m_pos;
+            
+            vector<int> hits;
+            shape_cast(movingHash, LAYER_ENEMY, bullet, motion,
+                       [&](int item) { return &enemies[movingHash.user(item)]; },
+                       [&](const CastHit &hit) { hits.push_back(movingHash.user(hit.m_item)); });
+            bullet.m_pos += motion;
+            for(int i : hits) {
+                if (i < npcs.size() && npcs.damage(i, PLAYER_BULLET_DAMAGE)) {
                     if (getSceneManagerPointer()->getSceneNode("enemy" + to_string(i)) != nullptr) {
-                        getEnginePointer()->deleteEventListener("enemy" + to_string(i));
 //                        getSceneManagerPointer()->deleteSceneNodeAndChildren("enemy" + to_string(i));
-                        getSceneManagerPointer()->getSceneNode("enemy" + to_string(i))->setTransform(translate(mat4(1), vec3(-50, 0, 0)));
+                        getSceneManagerPointer()->getSceneNode("enemy" + to_string(i))->snapTransform(translate(mat4(1), vec3(-50, 0, 0)));
                         enemies[i].m_pos = vec3(-50, 0, 0);
                         killedEnemies.push_back(i);
                     }
@@ -570,10 +309,10 @@ namespace ve {
                 direction =  (player.m_pos - vec3(0, 8, 0)) - enemies[i].m_pos;
         };
 
-        void onFrameStarted(veEvent event) {
+        void onSimulationStep(veEvent event) {
             glm::vec3 acceleration = direction * 1;
             m_pObject->multiplyTransform(glm::translate(glm::mat4(1.0f), acceleration * event.dt));
-            bullet.m_pos = m_pObject->getPosition();
+            vec3 motion = m_pObject->getPosition() - bullet.m_pos;
             
             if (bullet.m_pos.x >= 401 || bullet.m_pos.x <= -1 ||
                 bullet.m_pos.y >= 401 || bullet.m_pos.y <= -1 ||
@@ -584,98 +323,233 @@ namespace ve {
                 }
             }
             
-            vec3 p;
-            vec3 mtv = glm::vec3(0, 0.0f, 0);
-            if (abs(distance(bullet.m_pos, player.m_pos)) <= 3) {
-                auto hit1 = gjk( bullet, player, mtv, p, true);
-                if (hit1) {
-                    getEnginePointer()->end();
-                    cout << "You Lost" << endl;
-                }
+            float toi;
+            vec3 normal;
+            if (swept_aabb(bullet, motion).overlaps(collider_aabb(player)) && time_of_impact(bullet, motion, player, toi, normal)) {
+                getEnginePointer()->end();
+                cout << "You Lost" << endl;
             }
+            bullet.m_pos += motion;
         }
     };
 
-    class EnemyListener : public VEEventListener {
-        VESceneNode *m_pObject = nullptr;
-        int index;
-        Cell playerPosSave;
-        Cell oldStart;
-        unordered_map<Cell, Cell> parentSaved;
-        int counter = 0;
+    ///updates the shared navigation services before the enemies run
+    class NavigationListener : public VEEventListener {
     public:
         ///Constructor
-        EnemyListener(std::string name, VESceneNode *pObject, int index_) :
-            VEEventListener(name),  m_pObject(pObject), index(index_) {
-                playerPosSave = new Cell(floor(player.m_pos.x), floor(player.m_pos.z));
-        };
+        NavigationListener(std::string name) : VEEventListener(name) {};
 
-        void onFrameStarted(veEvent event) {
-            decide(event);
+        void onSimulationStep(veEvent event) {
+            if (chaseMode == CHASE_FLOW_FIELD) {
+                flowField.update(grid, Cell(floor(player.m_pos.x), floor(player.m_pos.z)), FLOW_FIELD_BUDGET, CHASE_RADIUS);
+            }
+            pathService.set_grid(grid, &jumpTable, &landmarks);
+            pathService.deliver();
+            aiScheduler.run(grid, &jumpTable, &hpaGraph);
+            losCache.begin_frame(grid);
+            if (pvsBuild.valid() && pvsBuild.wait_for(std::chrono::seconds(0)) == std::future_status::ready) pvs = pvsBuild.get();
         }
-        
-        void decide(veEvent event) {
-            Cell start = new Cell(floor(m_pObject->getPosition().x), floor(m_pObject->getPosition().z));
-            Cell end = new Cell(floor(player.m_pos.x), floor(player.m_pos.z));
-            vec3 p;
-            vec3 mtv = glm::vec3(0, 0.0f, 0);
-            auto killedPlayer = gjk( player, enemies[index], mtv, p, true);
-            if (killedPlayer) {
+    };
+
+    ///runs the AI of all enemies
+    ///the NPCs due this frame (see NpcSystem::schedule) first pick their state, then each state runs as one batch
+    class NPCListener : public VEEventListener {
+        vector<VESceneNode*> nodes;     //scene node of each NPC
+        vector<PathFollower> followers; //compressed, string-pulled path each NPC is walking
+        vector<NavMeshFollower> meshFollowers;  //path of CHASE_NAVMESH each NPC is walking
+        vector<PathTicket> tickets;     //search in flight of CHASE_PATH_ASYNC
+        vector<DStarLite> planners;     //searches of CHASE_INCREMENTAL
+        vector<Cell> pathSaved;         //scratch buffer the searches write their cells into
+        vector<NavPoint> meshPath;      //scratch buffer of the navmesh searches
+        vector<bool> shown;             //whether the scene node of each NPC is drawn
+    public:
+        ///Constructor
+        NPCListener(std::string name) : VEEventListener(name) {};
+
+        ///add the NPC with the next id, which must already exist in npcs
+        void add(VESceneNode *pObject) {
+            nodes.push_back(pObject);
+            followers.emplace_back();
+            meshFollowers.emplace_back();
+            shown.push_back(true);
+            tickets.push_back(PATH_NO_TICKET);
+            planners.emplace_back();
+        }
+
+        void onSimulationStep(veEvent event) {
+            npcs.schedule(player.m_pos.x, player.m_pos.z, event.dt);
+            for (int i : npcs.due) decide(i);
+            npcs.group_by_state();
+
+            for (int i : npcs.batches[NPC_CHASE]) chasePlayer(i);
+            for (int i : npcs.batches[NPC_ATTACK]) lookAndShoot(i);
+            rebuildMovingHash(getEnginePointer()->getThreadPool());
+            if (touchesPlayer()) {
                 getEnginePointer()->end();
                 cout << "You Lost" << endl;
             }
-            if (abs(end.x - start.x) <= 60 && abs(end.y - start.y) <= 60 && player.m_pos.y <= 8) {
-                chasePlayer(event);
+            cullHidden();
+        }
+
+        ///true if an enemy touches the player, only the enemies in the player's cells are tested
+        bool touchesPlayer() {
+            bool hit = false;
+            movingHash.query(collider_aabb(player), LAYER_ENEMY, [&](int item) {
+                hit = collide(player, enemies[movingHash.user(item)]);
+                return !hit;
+            });
+            return hit;
+        }
+
+        ///do not draw NPCs standing in regions the player's region cannot see
+        void cullHidden() {
+            Cell eye = cellOf(player.m_pos);
+            for (int i = 0; i < (int)nodes.size(); i++) {
+                bool visible = pvs.is_potentially_visible(grid, eye, cellOf(nodes[i]->getPosition()));
+                if (visible == shown[i]) continue;
+                getSceneManagerPointer()->setVisibility(nodes[i], visible);
+                shown[i] = visible;
             }
-            if (abs(end.x - start.x) <= 100 && abs(end.y - start.y) <= 100 && player.m_pos.y > 8) {
-                lookAndShoot(event);
+        }
+
+        Cell cellOf(vec3 pos) {
+            return Cell(floor(pos.x), floor(pos.z));
+        }
+
+        ///pick the state of NPC i for this tick
+        void decide(int i) {
+            Cell start = cellOf(nodes[i]->getPosition());
+            Cell end = cellOf(player.m_pos);
+            NpcState state = NPC_IDLE;
+            if (abs(end.x - start.x) <= CHASE_RADIUS && abs(end.y - start.y) <= CHASE_RADIUS && player.m_pos.y <= 8) {
+                state = NPC_CHASE;
+            } else if (abs(end.x - start.x) <= 100 && abs(end.y - start.y) <= 100 && player.m_pos.y > 8 &&
+                       pvs.is_potentially_visible(grid, start, end) && losCache.visible(grid, start, end)) {
+                state = NPC_ATTACK;
             }
+            npcs.state[i] = state;
         }
         
-        void lookAndShoot(veEvent event) {
-            if (getSceneManagerPointer()->getSceneNode("The enemy bullet" + to_string(index)) == nullptr) {
+        void lookAndShoot(int i) {
+            if (getSceneManagerPointer()->getSceneNode("The enemy bullet" + to_string(i)) == nullptr) {
                 VESceneNode *e0;
-                e0 = getSceneManagerPointer()->loadModel("The enemy bullet" + to_string(index), "media/models/test/crate0", "cube.obj", 0, getSceneManagerPointer()->getSceneNode("Level 1"));
+                e0 = getSceneManagerPointer()->loadModel("The enemy bullet" + to_string(i), "media/models/test/crate0", "cube.obj", 0, getSceneManagerPointer()->getSceneNode("Level 1"));
                 
                 e0->multiplyTransform( glm::scale(glm::mat4(1.0f), glm::vec3(.3f, 6.f, .3f)));
                 e0->lookAt(vec3(0,0,0), player.m_pos, vec3(0,0,1));
-                e0->multiplyTransform( translate(mat4(1), vec3(m_pObject->getPosition().x, 10, m_pObject->getPosition().z)));
+                e0->multiplyTransform( translate(mat4(1), vec3(nodes[i]->getPosition().x, 10, nodes[i]->getPosition().z)));
                 
-                getEnginePointer()->registerEventListener(new EnemyBulletListener("The enemy bullet" + to_string(index), e0, index), { veEvent::VE_EVENT_FRAME_STARTED});
+                getEnginePointer()->registerEventListener(new EnemyBulletListener("The enemy bullet" + to_string(i), e0, i), { veEvent::VE_EVENT_SIMULATION_STEP});
             }
         }
+
+        ///move NPC i by offset and keep its collider and its npcs entry in sync
+        void move(int i, vec3 offset) {
+            nodes[i]->multiplyTransform(glm::translate(glm::mat4(1.0f), offset));
+            enemies[i].m_pos = nodes[i]->getPosition();
+            npcs.x[i] = enemies[i].m_pos.x;
+            npcs.z[i] = enemies[i].m_pos.z;
+        }
         
-        void chasePlayer(veEvent event) {
-            Cell start = new Cell(floor(m_pObject->getPosition().x), floor(m_pObject->getPosition().z));
-            Cell end = new Cell(floor(player.m_pos.x), floor(player.m_pos.z));
+        void chasePlayer(int i) {
+            vec3 pos = nodes[i]->getPosition();
+            Cell start = cellOf(pos);
+            Cell end = cellOf(player.m_pos);
+            float dt = npcs.tick_dt[i];
+
+            if (chaseMode == CHASE_FLOW_FIELD) {
+                followFlowField(i, start, dt);
+                return;
+            }
+            if (chaseMode == CHASE_INCREMENTAL) {
+                followPlanner(i, start, end, dt);
+                return;
+            }
+            if (chaseMode == CHASE_NAVMESH) {
+                followNavMesh(i, pos, dt);
+                return;
+            }
         
-            if (parentSaved.empty() || parentSaved[playerPosSave] == start) {
-                unordered_map<Cell, Cell> parent;
-                unordered_map<Cell, double> cost;
-                if ((int)m_pObject->getPosition().x >= -5 && (int)m_pObject->getPosition().x <= 405 &&
-                    (int)m_pObject->getPosition().z >= -5 && (int)m_pObject->getPosition().z <= 405) {
+            PathFollower &follower = followers[i];
+            if (follower.done()) {
+                if ((int)pos.x >= -5 && (int)pos.x <= 405 && (int)pos.z >= -5 && (int)pos.z <= 405) {
                     if (end.x >= 0 && end.y >= 0 && end.x <= 400 && end.y <= 400) {
-                        a_star(grid, start, end, parent, cost);
-                        Cell current = end;
-//                        while (parent[current] != start) {
-//                            current = parent[current];
-//                        }
-//                        m_pObject->multiplyTransform(glm::translate(glm::mat4(1.0f), vec3(current.x - start.x, 0, current.y - start.y) * event.dt * 15));
-//                        enemies[index].m_pos = m_pObject->getPosition();
-                        playerPosSave = end;
-                        parentSaved = parent;
-                        oldStart = start;
+                        if (chaseMode == CHASE_PATH_ASYNC) {
+                            requestPath(i, start, end);
+                            return;
+                        }
+                        schedulePath(i, start, end);
                     }
                 }
             } else {
-                Cell current = playerPosSave;
-                while (parentSaved[current] != oldStart) {
-                    current = parentSaved[current];
-                }
-                oldStart = current;
-                m_pObject->multiplyTransform(glm::translate(glm::mat4(1.0f), vec3(current.x - start.x, 0, current.y - start.y) * event.dt * 15));
-                enemies[index].m_pos = m_pObject->getPosition();
+                Cell target;
+                if (!follower.next(pos.x, pos.z, PATH_ARRIVE_DISTANCE, target)) return;
+                //head for the centre of the next waypoint, which may be many cells away, without passing it
+                vec3 dir = vec3(target.x + 0.5f - pos.x, 0, target.y + 0.5f - pos.z);
+                float distance = glm::length(dir);
+                if (distance < 1e-4f) return;
+                move(i, dir * (std::min(dt * 15.0f, distance) / distance));
+            }
+        }
+
+        ///submit a search for start -> end, or pick up the result of the one in flight
+        void requestPath(int i, Cell start, Cell end) {
+            if (tickets[i] == PATH_NO_TICKET) {
+                tickets[i] = pathService.request(start, end);
+                return;
+            }
+            SearchStatus status;
+            if (!pathService.collect(tickets[i], pathSaved, status)) return;
+            tickets[i] = PATH_NO_TICKET;
+            if (status == SEARCH_FOUND) followers[i].set(grid, pathSaved);
+        }
+
+        ///queue a budgeted search for start -> end, or pick up its result once the scheduler finished it
+        void schedulePath(int i, Cell start, Cell end) {
+            SearchStatus status;
+            if (aiScheduler.collect(i, pathSaved, status)) {
+                if (status == SEARCH_FOUND) followers[i].set(grid, pathSaved);
+                return;
+            }
+            if (aiScheduler.pending(i)) return;
+            int distance = std::max(abs(end.x - start.x), abs(end.y - start.y));
+            PathMode mode = distance > HPA_MIN_DISTANCE ? PATH_HPA : pathMode;
+            aiScheduler.request(i, start, end, (float)distance, mode);
+        }
+
+        ///repair the D* Lite search for the current cells and walk toward the centre of the next cell
+        ///the step stops at the centre, so the NPC stays on the path the planner is rooted on
+        void followPlanner(int i, Cell start, Cell end, float dt) {
+            Cell current;
+            if (planners[i].plan(grid, start, end) != SEARCH_FOUND || !planners[i].next(grid, start, current)) return;
+            vec3 pos = nodes[i]->getPosition();
+            vec3 dir = vec3(current.x + 0.5f - pos.x, 0, current.y + 0.5f - pos.z);
+            float distance = glm::length(dir);
+            if (distance < 1e-4f) return;
+            move(i, dir * (std::min(dt * 15.0f, distance) / distance));
+        }
+
+        ///walk the navmesh path toward the player, replanning when the player moved away from its end
+        void followNavMesh(int i, vec3 pos, float dt) {
+            NavPoint here{ pos.x, pos.z };
+            NavPoint goal{ player.m_pos.x, player.m_pos.z };
+            NavMeshFollower &follower = meshFollowers[i];
+            if (follower.done() || nav_distance(follower.goal(), goal) > NAVMESH_REPLAN_DISTANCE) {
+                if (!navMesh.find_path(here, goal, meshPath)) return;
+                follower.set(meshPath);
             }
+            NavPoint target;
+            if (!follower.next(here, NAVMESH_ARRIVE_DISTANCE, target)) return;
+            vec3 dir = vec3(target.x - pos.x, 0, target.z - pos.z);
+            float distance = glm::length(dir);
+            if (distance < 1e-4f) return;
+            move(i, dir * (std::min(dt * 15.0f, distance) / distance));
+        }
+
+        void followFlowField(int i, Cell start, float dt) {
+            Cell current;
+            if (!flowField.next(grid, start, current)) return;
+            move(i, vec3(current.x - start.x, 0, current.y - start.y) * dt * 15.0f);
         }
     };
 
@@ -686,18 +560,12 @@ namespace ve {
         double F, I;
         int m;
         double force;
-        glm::vec3 net_F;
-        glm::vec3 gravity;
-        glm::vec3 idleF;
-        bool pressed = false;
         int counter = 0;
+        glm::vec3 walk = glm::vec3(0.0f);   //walking velocity asked for by the keys held this frame
     public:
         ///Constructor
         CharacterMovementListener(std::string name, VESceneNode *pObject, VESceneNode *camera_, VEEngine *eng) :
             VEEventListener(name),  m_pObject(pObject), camera(camera_), engine(eng)  {
-                net_F = glm::vec3(0.f, 400.f, 0.f);
-                idleF = glm::vec3(0.f, 0.f, 0.f);
-                gravity = glm::vec3(0.f, -9.8f, 0.f);
                 m = 1;
         };
 
@@ -725,7 +593,7 @@ namespace ve {
                 e0->multiplyTransform( camera->getTransform());
                 e0->multiplyTransform( m_pObject->getTransform());
                 
-                engine->registerEventListener(new BulletListener("bullet" + to_string(counter), e0, camera->getZAxis(), counter), { veEvent::VE_EVENT_FRAME_STARTED});
+                engine->registerEventListener(new BulletListener("bullet" + to_string(counter), e0, camera->getZAxis(), counter), { veEvent::VE_EVENT_SIMULATION_STEP});
                 counter++;
                 
             }
@@ -739,9 +607,9 @@ namespace ve {
             }
 
             if (event.idata1 == GLFW_KEY_SPACE && event.idata3 == GLFW_PRESS) {
-                if (!pressed) {
-                    net_F = glm::vec3(0.f, 100.f, 0.f);
-                    pressed = true;
+                if (physicsWorld.supported(playerBody, vec3(0.0f, 1.0f, 0.0f))) {
+                    physicsWorld.body(playerBody).m_vel.y = PLAYER_JUMP_SPEED;
+                    physicsWorld.wake(playerBody);
                 }
             }
             
@@ -768,64 +636,34 @@ namespace ve {
                     break;
             }
             
-            glm::vec3 trans = 30.0f * glm::vec3(translate.x, translate.y, translate.z);
-            Box testHit = player;
-            testHit.m_pos = glm::translate(glm::mat4(1.0f), (float)event.dt * trans) * vec4(player.m_pos, 1);
-            
-            bool canWalk = true;
-            for(Box wall : wallsValues) {
-                vec3 p;
-                vec3 mtv = glm::vec3(0, 0.0f, 0);
-                auto hitWall = gjk( testHit, wall, mtv, p, true);
-                if (hitWall) {
-                    canWalk = false;
-                }
-            }
-            if (canWalk) {
-                player.m_pos = glm::translate(glm::mat4(1.0f), (float)event.dt * trans) * vec4(player.m_pos, 1);
-                m_pObject->multiplyTransform( glm::translate(glm::mat4(1.0f), (float)event.dt * trans) );
-            }
+            walk += 30.0f * glm::vec3(translate.x, translate.y, translate.z);
             return false;
         }
-        
+
+        ///held keys are sent again every frame and ask for the walk anew
         void onFrameStarted(veEvent event) {
-            if (pressed) {
-                net_F += (gravity * (float) m);
-                glm::vec3 acceleration = (net_F / (float) m) * (float) event.dt;
-                auto temp = player.m_pos;
-                player.m_pos = glm::translate(glm::mat4(1.0f), acceleration) * vec4(player.m_pos, 1);
-                for(Box f : floors) {
-                    vec3 p;
-                    vec3 mtv = glm::vec3(0, 0.0f, 0);
-                    auto hit1 = gjk( player, f, mtv, p, true);
-                    if (hit1) {
-                        acceleration = vec3(0, 0, 0);
-                        pressed = false;
-                    }
-                }
-                player.m_pos = temp;
-                m_pObject->multiplyTransform(glm::translate(glm::mat4(1.0f), acceleration));
-                player.m_pos = glm::translate(glm::mat4(1.0f), acceleration) * vec4(player.m_pos, 1);
-            } else {
-                if (player.m_pos.y > 8) {
-                    idleF += (gravity * (float) m);
-                    glm::vec3 acceleration = (idleF / (float) m) * (float) event.dt;
-                    auto temp = player.m_pos;
-                    player.m_pos = glm::translate(glm::mat4(1.0f), acceleration) * vec4(player.m_pos, 1);
-                    for(Box f : floors) {
-                        vec3 p;
-                        vec3 mtv = glm::vec3(0, 0.0f, 0);
-                        auto hit1 = gjk( player, f, mtv, p, true);
-                        if (hit1) {
-                            acceleration = vec3(0, 0, 0);
-                            idleF = vec3(0, 0, 0);
-                        }
-                    }
-                    player.m_pos = temp;
-                    m_pObject->multiplyTransform(glm::translate(glm::mat4(1.0f), acceleration));
-                    player.m_pos = glm::translate(glm::mat4(1.0f), acceleration) * vec4(player.m_pos, 1);
+            walk = glm::vec3(0.0f);
+        }
+
+        ///walks the player, gravity, jumps and landing come from the physics world, which moves the player collider
+        void onSimulationStep(veEvent event) {
+            glm::vec3 trans = (float)event.dt * walk;
+            if (trans != glm::vec3(0.0f)) {
+                Box testHit = player;
+                testHit.m_pos = player.m_pos + trans;
+                testHit.m_pos.y += PLAYER_SKIN;     //do not count the block the player stands on as a wall
+                
+                bool canWalk = !overlapsStatic(testHit, LAYER_WALL, wallsValues, wallBatch);
+                if (canWalk) {
+                    physicsWorld.set_position(playerBody, player.m_pos + trans);
+                    m_pObject->multiplyTransform( glm::translate(glm::mat4(1.0f), trans) );
                 }
             }
+
+            vec3 before = player.m_pos;
+            physicsWorld.step((float)event.dt, engine->getThreadPool());
+            m_pObject->multiplyTransform(glm::translate(glm::mat4(1.0f), player.m_pos - before));
+
             if (killedEnemies.size() >= 5) {
                 getEnginePointer()->end();
                 cout << "You Won!" << endl;
@@ -844,7 +682,7 @@ namespace ve {
 		* \param[in] debug Switch debuggin on or off
 		*/
 		MyVulkanEngine( bool debug=false) : VEEngine(debug) {};
-		~MyVulkanEngine() {};
+		~MyVulkanEngine() { stopPvsBuild(); };
 
 		///Register an event listener to interact with the user
 		virtual void registerEventListeners() {
@@ -876,6 +714,8 @@ namespace ve {
 		}
         
         void loadEnemies(VESceneNode *pScene) {
+            NPCListener *pListener = new NPCListener("NPCs");
+            npcs.clear();
             int size = *(&enemies + 1) - enemies;
             for(int i = 0; i < size; i++) {
                 VESceneNode *e2;
@@ -885,144 +725,84 @@ namespace ve {
                 e2->multiplyTransform( glm::rotate(glm::mat4(1.0f), angle, glm::vec3(1.0f, 0.0f, 0.0f)));
                 e2->multiplyTransform( glm::translate(glm::mat4(1.0f), glm::vec3(enemies[i].m_pos.x, enemies[i].m_pos.y, enemies[i].m_pos.z)));
                 
-                registerEventListener(new EnemyListener("enemy" + to_string(i), e2, i), { veEvent::VE_EVENT_FRAME_STARTED});
+                npcs.add(enemies[i].m_pos.x, enemies[i].m_pos.z);
+                pListener->add(e2);
             }
+            rebuildMovingHash();
+            registerEventListener(pListener, { veEvent::VE_EVENT_SIMULATION_STEP});
         }
         
-        void loadWalls(VESceneNode *pScene) {
-            //1
+        //load the cube model of a static block and add its collider
+        Box loadBlock(VESceneNode *pScene, const LevelBlock &block) {
+            vec3 center(block.center[0], block.center[1], block.center[2]);
+            vec3 size(block.size[0], block.size[1], block.size[2]);
             VESceneNode *e2;
-            VECHECKPOINTER( e2 = getSceneManagerPointer()->loadModel("The Cube0", "media/models/test/crate0", "cube.obj", 0, pScene));
-            e2->multiplyTransform( glm::scale(glm::mat4(1.0f), glm::vec3(10.0f, 20.0f, 100.0f)));
-            e2->multiplyTransform( glm::translate(glm::mat4(1.0f), glm::vec3(75, 10.0f, 100)));
-            
-            Box wall1{ {75.0f, 10.0f, 100.0f}, scale( mat4(1.0f), vec3(10.0f, 20.0f, 100.0f))};
-            wallsValues.push_back(wall1);
-            //2
-            VESceneNode *e3;
-            VECHECKPOINTER( e3 = getSceneManagerPointer()->loadModel("The Cube1", "media/models/test/crate0", "cube.obj", 0, pScene));
-            e3->multiplyTransform( glm::scale(glm::mat4(1.0f), glm::vec3(100.0f, 20.0f, 10.0f)));
-            e3->multiplyTransform( glm::translate(glm::mat4(1.0f), glm::vec3(120, 10.0f, 45)));
-            
-            Box wall2{ {120.0f, 10.0f, 45.0f}, scale( mat4(1.0f), vec3(100.0f, 20.0f, 10.0f))};
-            wallsValues.push_back(wall2);
-            
-            //3
-            VECHECKPOINTER( e2 = getSceneManagerPointer()->loadModel("The Cube3", "media/models/test/crate0", "cube.obj", 0, pScene));
-            e2->multiplyTransform( glm::scale(glm::mat4(1.0f), glm::vec3(10.0f, 20.0f, 100.0f)));
-            e2->multiplyTransform( glm::translate(glm::mat4(1.0f), glm::vec3(235, 10.0f, 200)));
-            
-            Box wall3{ {235, 10.0f, 200}, scale( mat4(1.0f), vec3(10.0f, 20.0f, 100.0f))};
-            wallsValues.push_back(wall3);
-            //4
-            VECHECKPOINTER( e3 = getSceneManagerPointer()->loadModel("The Cube4", "media/models/test/crate0", "cube.obj", 0, pScene));
-            e3->multiplyTransform( glm::scale(glm::mat4(1.0f), glm::vec3(80.0f, 20.0f, 10.0f)));
-            e3->multiplyTransform( glm::translate(glm::mat4(1.0f), glm::vec3(190, 10.0f, 245)));
-            
-            Box wall4{ {190.0f, 10.0f, 245.0f}, scale( mat4(1.0f), vec3(80.0f, 20.0f, 10.0f))};
-            wallsValues.push_back(wall4);
-            
-            //5
-            VECHECKPOINTER( e2 = getSceneManagerPointer()->loadModel("The Cube5", "media/models/test/crate0", "cube.obj", 0, pScene));
-            e2->multiplyTransform( glm::scale(glm::mat4(1.0f), glm::vec3(10.0f, 20.0f, 100.0f)));
-            e2->multiplyTransform( glm::translate(glm::mat4(1.0f), glm::vec3(125, 10.0f, 350)));
-            
-            Box wall5{ {125, 10.0f, 350}, scale( mat4(1.0f), vec3(10.0f, 20.0f, 100.0f))};
-            wallsValues.push_back(wall5);
-            //6
-            VECHECKPOINTER( e3 = getSceneManagerPointer()->loadModel("The Cube6", "media/models/test/crate0", "cube.obj", 0, pScene));
-            e3->multiplyTransform( glm::scale(glm::mat4(1.0f), glm::vec3(100.0f, 20.0f, 10.0f)));
-            e3->multiplyTransform( glm::translate(glm::mat4(1.0f), glm::vec3(70, 10.0f, 395)));
-            
-            Box wall6{ {70.0f, 10.0f, 395.0f}, scale( mat4(1.0f), vec3(100.0f, 20.0f, 10.0f))};
-            wallsValues.push_back(wall6);
-            
-            //7
-            VECHECKPOINTER( e2 = getSceneManagerPointer()->loadModel("The Cube7", "media/models/test/crate0", "cube.obj", 0, pScene));
-            e2->multiplyTransform( glm::scale(glm::mat4(1.0f), glm::vec3(10.0f, 20.0f, 100.0f)));
-            e2->multiplyTransform( glm::translate(glm::mat4(1.0f), glm::vec3(255, 10.0f, 350)));
-            
-            Box wall7{ {255, 10.0f, 350}, scale( mat4(1.0f), vec3(10.0f, 20.0f, 100.0f))};
-            wallsValues.push_back(wall7);
-            //8
-            VECHECKPOINTER( e3 = getSceneManagerPointer()->loadModel("The Cube8", "media/models/test/crate0", "cube.obj", 0, pScene));
-            e3->multiplyTransform( glm::scale(glm::mat4(1.0f), glm::vec3(100.0f, 20.0f, 10.0f)));
-            e3->multiplyTransform( glm::translate(glm::mat4(1.0f), glm::vec3(310, 10.0f, 305)));
-            
-            Box wall8{ {310, 10.0f, 305.0f}, scale( mat4(1.0f), vec3(100.0f, 20.0f, 10.0f))};
-            wallsValues.push_back(wall8);
-            
-            //9
-            VECHECKPOINTER( e3 = getSceneManagerPointer()->loadModel("The Cube9", "media/models/test/crate0", "cube.obj", 0, pScene));
-            e3->multiplyTransform( glm::scale(glm::mat4(1.0f), glm::vec3(10.0f, 20.0f, 100.0f)));
-            e3->multiplyTransform( glm::translate(glm::mat4(1.0f), glm::vec3(275, 10.0f, 150)));
-            
-            Box wall9{ {275, 10.0f, 150}, scale( mat4(1.0f), vec3(10.0f, 20.0f, 100.0f))};
-            wallsValues.push_back(wall9);
+            VECHECKPOINTER( e2 = getSceneManagerPointer()->loadModel(block.name, "media/models/test/crate0", "cube.obj", 0, pScene));
+            e2->multiplyTransform( glm::scale(glm::mat4(1.0f), size));
+            e2->multiplyTransform( glm::translate(glm::mat4(1.0f), center));
+
+            Box box{ center, scale( mat4(1.0f), size)};
+            colliderTree.insert(collider_aabb(box), (int)wallsValues.size(), LAYER_WALL);
+            wallBatch.add(box, (int)wallsValues.size());
+            wallsValues.push_back(box);
+            return box;
+        }
+
+        void loadWalls(VESceneNode *pScene) {
+            for (const LevelBlock &block : LEVEL_ONE_WALLS) loadBlock(pScene, block);
         }
         
         void buildOuterWalls(VESceneNode *pScene) {
-            //1
-            VESceneNode *e2;
-            VECHECKPOINTER( e2 = getSceneManagerPointer()->loadModel("outerWall1", "media/models/test/crate0", "cube.obj", 0, pScene));
-            e2->multiplyTransform( glm::scale(glm::mat4(1.0f), glm::vec3(3.0f, 40.0f, 400.0f)));
-            e2->multiplyTransform( glm::translate(glm::mat4(1.0f), glm::vec3(-1, 20.0f, 200)));
-            
-            Box wall1{ {-1, 20.0f, 200}, scale( mat4(1.0f), vec3(3.0f, 40.0f, 400.0f))};
-            wallsValues.push_back(wall1);
-            
-            //2
-            VECHECKPOINTER( e2 = getSceneManagerPointer()->loadModel("outerWall2", "media/models/test/crate0", "cube.obj", 0, pScene));
-            e2->multiplyTransform( glm::scale(glm::mat4(1.0f), glm::vec3(3.0f, 40.0f, 400.0f)));
-            e2->multiplyTransform( glm::translate(glm::mat4(1.0f), glm::vec3(401, 20.0f, 200)));
-            
-            Box wall2{ {401, 20.0f, 200}, scale( mat4(1.0f), vec3(3.0f, 40.0f, 400.0f))};
-            wallsValues.push_back(wall2);
-            
-            //3
-            VECHECKPOINTER( e2 = getSceneManagerPointer()->loadModel("outerWall3", "media/models/test/crate0", "cube.obj", 0, pScene));
-            e2->multiplyTransform( glm::scale(glm::mat4(1.0f), glm::vec3(400.0f, 40.0f, 3.0f)));
-            e2->multiplyTransform( glm::translate(glm::mat4(1.0f), glm::vec3(200, 20.0f, -1)));
-            
-            Box wall3{ {200, 20.0f, -1}, scale( mat4(1.0f), vec3(400.0f, 40.0f, 3.0f))};
-            wallsValues.push_back(wall3);
-            
-            //4
-            VECHECKPOINTER( e2 = getSceneManagerPointer()->loadModel("outerWall4", "media/models/test/crate0", "cube.obj", 0, pScene));
-            e2->multiplyTransform( glm::scale(glm::mat4(1.0f), glm::vec3(400.0f, 40.0f, 3.0f)));
-            e2->multiplyTransform( glm::translate(glm::mat4(1.0f), glm::vec3(200, 20.0f, 401)));
-            
-            Box wall4{ {200, 20.0f, 401}, scale( mat4(1.0f), vec3(400.0f, 40.0f, 3.0f))};
-            wallsValues.push_back(wall4);
+            for (const LevelBlock &block : LEVEL_ONE_OUTER_WALLS) loadBlock(pScene, block);
         }
         
         void buildFloors(VESceneNode *pScene) {
-            //1
-            VESceneNode *e2;
-            VECHECKPOINTER( e2 = getSceneManagerPointer()->loadModel("floor1", "media/models/test/crate0", "cube.obj", 0, pScene));
-            e2->multiplyTransform( glm::scale(glm::mat4(1.0f), glm::vec3(10.0f, 2.0f, 10.0f)));
-            e2->multiplyTransform( glm::translate(glm::mat4(1.0f), glm::vec3(170, 10.0f, 100)));
-            
-            Box floor1{ {170, 10.0f, 100}, scale( mat4(1.0f), vec3(10.0f, 2.0f, 10.0f))};
-            floors.push_back(floor1);
-            wallsValues.push_back(floor1);
-            
-            VECHECKPOINTER( e2 = getSceneManagerPointer()->loadModel("floor2", "media/models/test/crate0", "cube.obj", 0, pScene));
-            e2->multiplyTransform( glm::scale(glm::mat4(1.0f), glm::vec3(20.0f, 2.0f, 20.0f)));
-            e2->multiplyTransform( glm::translate(glm::mat4(1.0f), glm::vec3(100, 10.0f, 300)));
-            
-            Box floor2{ {100, 10.0f, 300}, scale( mat4(1.0f), vec3(20.0f, 2.0f, 20.0f))};
-            floors.push_back(floor2);
-            wallsValues.push_back(floor2);
-            
-            VECHECKPOINTER( e2 = getSceneManagerPointer()->loadModel("floor3", "media/models/test/crate0", "cube.obj", 0, pScene));
-            e2->multiplyTransform( glm::scale(glm::mat4(1.0f), glm::vec3(20.0f, 2.0f, 20.0f)));
-            e2->multiplyTransform( glm::translate(glm::mat4(1.0f), glm::vec3(320, 10.0f, 250)));
-            
-            Box floor3{ {320, 10.0f, 250}, scale( mat4(1.0f), vec3(20.0f, 2.0f, 20.0f))};
-            floors.push_back(floor3);
-            wallsValues.push_back(floor3);
-            floors.push_back(ground);
+            for (const LevelBlock &block : LEVEL_ONE_FLOORS) loadBlock(pScene, block);
+        }
+
+        //static bodies for the blocks and the ground, and the player as the one dynamic body
+        //must run after the blocks are loaded, the bodies point into wallsValues
+        void buildPhysicsWorld() {
+            physicsWorld.clear();
+            physicsWorld.m_gravity = PLAYER_GRAVITY;
+            for (Box &box : wallsValues) physicsWorld.add_static(box);
+            physicsWorld.add_static(ground);
+            playerBody = physicsWorld.add_body(player, 1.0f, true);
+        }
+
+        //bake the nav grid from the static colliders, or map it from the cache if they did not change
+        void loadNavigation() {
+            NavBakeSettings settings;
+            vector<NavCollider> colliders;
+            for (Box &box : wallsValues) colliders.push_back(navCollider(box));
+            uint64_t key = nav_bake_key(settings, colliders);
+            nav_cache_make_dir(NAV_CACHE_DIR);
+            if (!nav_cache_load(NAV_CACHE_FILE, key, grid)) {
+                nav_bake(grid, settings, colliders, getThreadPool());
+                nav_cache_write(NAV_CACHE_FILE, key, grid);
+            }
+            stopPvsBuild();
+            if (!pvs_cache_load(PVS_CACHE_FILE, key, grid, pvs)) {
+                //the build takes seconds, so it runs on its own thread on a copy of the grid, off the
+                //frame and the engine pool; until it is swapped in, the empty set sees everything
+                pvs = PotentiallyVisibleSet();
+                pvsBuild = std::async(std::launch::async, [key](NavGrid copy) {
+                    PotentiallyVisibleSet built;
+                    built.build(copy, 32, nullptr, &pvsCancel);
+                    if (!pvsCancel) pvs_cache_write(PVS_CACHE_FILE, key, built);
+                    return built;
+                }, grid);
+            }
+            navMesh.build(settings, colliders);
+        }
+
+        //cancel a background PVS build and wait for its thread, its set is dropped
+        void stopPvsBuild() {
+            if (!pvsBuild.valid()) return;
+            pvsCancel = true;
+            pvsBuild.wait();
+            pvsBuild = std::future<PotentiallyVisibleSet>();
+            pvsCancel = false;
         }
 
         void loadLevelOne(VESceneNode *pScene) {
@@ -1035,13 +815,28 @@ namespace ve {
 
             int counter = 0;
             
-            registerEventListener(new CharacterMovementListener("Jumper", getSceneManagerPointer()->getCamera()->getParent(), getSceneManagerPointer()->getCamera(), this), { veEvent::VE_EVENT_MOUSEBUTTON, veEvent::VE_EVENT_KEYBOARD, veEvent::VE_EVENT_FRAME_STARTED});
+            registerEventListener(new CharacterMovementListener("Jumper", getSceneManagerPointer()->getCamera()->getParent(), getSceneManagerPointer()->getCamera(), this), { veEvent::VE_EVENT_MOUSEBUTTON, veEvent::VE_EVENT_KEYBOARD, veEvent::VE_EVENT_FRAME_STARTED, veEvent::VE_EVENT_SIMULATION_STEP});
             
-            loadWallsLogic(grid);
-            loadEnemies(pScene);
+            wallsValues.clear();
+            colliderTree.clear();
+            wallBatch.clear();
             loadWalls(pScene);
             buildOuterWalls(pScene);
             buildFloors(pScene);
+            buildPhysicsWorld();
+
+            loadNavigation();
+            jumpTable.build(grid);
+            hpaGraph.build(grid);
+            landmarks.build(grid, NUM_LANDMARKS);
+            pathService.set_thread_pool(getThreadPool());
+            pathService.set_mode(pathMode);
+            aiScheduler.clear();
+            aiScheduler.set_budget(AI_BUDGET_US);
+            aiScheduler.set_landmarks(&landmarks);
+            aiScheduler.reserve(grid);
+            registerEventListener(new NavigationListener("Navigation"), { veEvent::VE_EVENT_SIMULATION_STEP});
+            loadEnemies(pScene);
         }
 
 